@@ -0,0 +1,47 @@
+/*
+ * Allocation Counting for Benchmarks
+ *
+ * Copyright (c) 2025 Alexei A. Smekalkine <ikle@ikle.ru>
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#ifndef ALLOCS_H
+#define ALLOCS_H  1
+
+#include <stddef.h>
+
+/*
+ * Wraps the allocator entry points of the C library to count calls in
+ * allocs. It defines malloc, calloc and realloc, thus it is included by
+ * one translation unit of a benchmark tool only, never by the library.
+ */
+static size_t allocs;
+
+#ifdef __GLIBC__
+
+extern void *__libc_malloc  (size_t size);
+extern void *__libc_calloc  (size_t n, size_t size);
+extern void *__libc_realloc (void *p, size_t size);
+
+void *malloc (size_t size)
+{
+	++allocs;
+	return __libc_malloc (size);
+}
+
+void *calloc (size_t n, size_t size)
+{
+	++allocs;
+	return __libc_calloc (n, size);
+}
+
+void *realloc (void *p, size_t size)
+{
+	++allocs;
+	return __libc_realloc (p, size);
+}
+
+#endif  /* __GLIBC__ */
+
+#endif  /* ALLOCS_H */
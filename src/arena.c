@@ -0,0 +1,84 @@
+/*
+ * Memory Arena
+ *
+ * Copyright (c) 2025 Alexei A. Smekalkine <ikle@ikle.ru>
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <errno.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "arena.h"
+
+#define ARENA_CHUNK	65536
+#define ARENA_ALIGN	(_Alignof (max_align_t))
+
+struct arena_chunk {
+	struct arena_chunk *next;
+	max_align_t data[];
+};
+
+void arena_fini (struct arena *o)
+{
+	struct arena_chunk *c, *next;
+
+	for (c = o->chunk; c != NULL; c = next) {
+		next = c->next;
+		free (c);
+	}
+
+	arena_init (o);
+}
+
+static void *arena_chunk (struct arena *o, size_t size)
+{
+	struct arena_chunk *c;
+
+	if (size > (size_t) -1 - sizeof (*c)) {  /* size overflow */
+		errno = ENOMEM;
+		return NULL;
+	}
+
+	if ((c = malloc (sizeof (*c) + size)) == NULL)
+		return NULL;
+
+	c->next  = o->chunk;
+	o->chunk = c;
+	return c->data;
+}
+
+static void *arena_take (struct arena *o, size_t size, size_t align)
+{
+	size_t pad = -(uintptr_t) o->next & (align - 1);
+	char *p;
+
+	if (size > ARENA_CHUNK / 4)
+		return arena_chunk (o, size);
+
+	if (pad + size > o->avail) {
+		if ((p = arena_chunk (o, ARENA_CHUNK)) == NULL)
+			return NULL;
+
+		o->next  = p;
+		o->avail = ARENA_CHUNK;
+		pad = 0;
+	}
+
+	p = o->next + pad;
+	o->next   = p + size;
+	o->avail -= pad + size;
+	return p;
+}
+
+void *arena_alloc (struct arena *o, size_t size)
+{
+	return arena_take (o, size, ARENA_ALIGN);
+}
+
+void *arena_alloc_bytes (struct arena *o, size_t size)
+{
+	return arena_take (o, size, 1);
+}
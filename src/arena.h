@@ -0,0 +1,42 @@
+/*
+ * Memory Arena
+ *
+ * Copyright (c) 2025 Alexei A. Smekalkine <ikle@ikle.ru>
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#ifndef ARENA_H
+#define ARENA_H  1
+
+#include <stddef.h>
+
+struct arena_chunk;
+
+struct arena {
+	struct arena_chunk *chunk;	/* list of all allocated chunks	*/
+	char *next;			/* free space in current chunk	*/
+	size_t avail;			/* size of free space		*/
+};
+
+static inline void arena_init (struct arena *o)
+{
+	o->chunk = NULL;
+	o->next  = NULL;
+	o->avail = 0;
+}
+
+/*
+ * arena_fini releases all the memory allocated from the arena at once.
+ *
+ * arena_alloc allocates a block of the specified size aligned for any
+ * object type. Blocks are carved sequentially from large chunks, requests
+ * larger than a quarter of the chunk size get a chunk of their own.
+ *
+ * arena_alloc_bytes allocates a block with no alignment, for strings.
+ */
+void  arena_fini  (struct arena *o);
+void *arena_alloc (struct arena *o, size_t size);
+void *arena_alloc_bytes (struct arena *o, size_t size);
+
+#endif  /* ARENA_H */
@@ -0,0 +1,142 @@
+/*
+ * ASCII Bit Packing Kernels
+ *
+ * Copyright (c) 2025 Alexei A. Smekalkine <ikle@ikle.ru>
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <string.h>
+
+#include "bitpack.h"
+
+#ifdef __x86_64__
+#define BITPACK_X86  1
+#include <immintrin.h>
+#endif
+
+static inline uint64_t bitpack_read_scalar (const char *s, uint64_t *ones)
+{
+	uint64_t valid = 0, set = 0, bit;
+	unsigned i;
+
+	for (i = 0; i < 64; ++i) {
+		bit = (uint64_t) 1 << i;
+
+		switch (s[i]) {
+		case '1':
+			set |= bit;
+			/* fall through */
+		case '0':
+			valid |= bit;
+		}
+	}
+
+	*ones = set;
+	return valid;
+}
+
+#ifdef BITPACK_X86
+
+static uint64_t bitpack_read_sse2 (const char *s, uint64_t *ones)
+{
+	const __m128i c0 = _mm_set1_epi8 ('0');
+	const __m128i c1 = _mm_set1_epi8 ('1');
+	uint64_t valid = 0, set = 0;
+	__m128i x, z, o;
+	unsigned i;
+
+	for (i = 0; i < 64; i += 16) {
+		x = _mm_loadu_si128 ((const void *) (s + i));
+		z = _mm_cmpeq_epi8 (x, c0);
+		o = _mm_cmpeq_epi8 (x, c1);
+
+		set   |= (uint64_t) (uint16_t) _mm_movemask_epi8 (o) << i;
+		valid |= (uint64_t) (uint16_t) _mm_movemask_epi8 (_mm_or_si128 (z, o)) << i;
+	}
+
+	*ones = set;
+	return valid;
+}
+
+__attribute__ ((target ("avx2")))
+static uint64_t bitpack_read_avx2 (const char *s, uint64_t *ones)
+{
+	const __m256i c0 = _mm256_set1_epi8 ('0');
+	const __m256i c1 = _mm256_set1_epi8 ('1');
+	uint64_t valid = 0, set = 0;
+	__m256i x, z, o;
+	unsigned i;
+
+	for (i = 0; i < 64; i += 32) {
+		x = _mm256_loadu_si256 ((const void *) (s + i));
+		z = _mm256_cmpeq_epi8 (x, c0);
+		o = _mm256_cmpeq_epi8 (x, c1);
+
+		set   |= (uint64_t) (uint32_t) _mm256_movemask_epi8 (o) << i;
+		valid |= (uint64_t) (uint32_t) _mm256_movemask_epi8 (_mm256_or_si256 (z, o)) << i;
+	}
+
+	*ones = set;
+	return valid;
+}
+
+#endif  /* BITPACK_X86 */
+
+static uint64_t bitpack_read_init (const char *s, uint64_t *ones)
+{
+#ifdef BITPACK_X86
+	__builtin_cpu_init ();
+
+	bitpack_read = __builtin_cpu_supports ("avx2") ? bitpack_read_avx2 :
+						       bitpack_read_sse2;
+#else
+	bitpack_read = bitpack_read_scalar;
+#endif
+	return bitpack_read (s, ones);
+}
+
+uint64_t (*bitpack_read) (const char *s, uint64_t *ones) = bitpack_read_init;
+
+/*
+ * Select the kernel at startup, before any threads are created, so that
+ * parsers running in parallel never race on the dispatch pointer.
+ */
+__attribute__ ((constructor))
+static void bitpack_init (void)
+{
+	static const char block[64];
+	uint64_t ones;
+
+	if (bitpack_read == bitpack_read_init)
+		(void) bitpack_read_init (block, &ones);
+}
+
+/*
+ * Spread eight bits of a byte into eight bytes of a word with a single
+ * multiplication, then turn every non-zero byte into '1' and every zero
+ * byte into '0'.
+ */
+static inline uint64_t bitpack_spread (unsigned b)
+{
+	const uint64_t ones = 0x0101010101010101ull;
+	uint64_t x = (b * ones) & 0x8040201008040201ull;
+
+	x = ((x + 0x7f7f7f7f7f7f7f7full) >> 7) & ones;
+	return x + ones * '0';
+}
+
+void bitpack_write (char *to, const unsigned char *from, size_t count)
+{
+	size_t i;
+	uint64_t x;
+
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+	for (; count >= 8; to += 8, count -= 8) {
+		x = bitpack_spread (*from++);
+		memcpy (to, &x, 8);
+	}
+#endif
+	for (i = 0; i < count; ++i)
+		to[i] = (from[i / 8] & 1u << (i & 7)) != 0 ? '1' : '0';
+}
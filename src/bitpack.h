@@ -0,0 +1,30 @@
+/*
+ * ASCII Bit Packing Kernels
+ *
+ * Copyright (c) 2025 Alexei A. Smekalkine <ikle@ikle.ru>
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#ifndef BITPACK_H
+#define BITPACK_H  1
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * bitpack_read classifies 64 characters starting at s. Returns a mask
+ * where bit i is set if s[i] is either '0' or '1', and stores the mask of
+ * '1' characters into ones. The first character maps to the least
+ * significant bit. At least 64 characters must be readable at s. The best
+ * kernel for the running CPU is selected on the first call.
+ */
+extern uint64_t (*bitpack_read) (const char *s, uint64_t *ones);
+
+/*
+ * bitpack_write expands count bits from the packed array (least significant
+ * bit of each byte first) into count '0' or '1' ASCII characters.
+ */
+void bitpack_write (char *to, const unsigned char *from, size_t count);
+
+#endif  /* BITPACK_H */
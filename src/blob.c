@@ -7,16 +7,36 @@
  */
 
 #include <errno.h>
+#include <stdarg.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
 #include "blob.h"
 
-static int blob_resize (struct blob *o, size_t size)
+int blob_reserve (struct blob *o, size_t count)
 {
+	const size_t need = o->count + count;
+	size_t size = o->size + o->size / 2;
 	void *data;
 
-	if ((data = realloc (o->data, size)) == NULL)
+	if (need < o->count) {		/* size overflow */
+		errno = ENOMEM;
+		return 0;
+	}
+
+	if (need <= o->size)
+		return 1;
+
+	if (size < need)
+		size = need;
+
+	if (o->data != o->buf)
+		data = realloc (o->data, size);
+	else if ((data = malloc (size)) != NULL)
+		memcpy (data, o->buf, o->count);
+
+	if (data == NULL)
 		return 0;
 
 	o->size = size;
@@ -24,19 +44,42 @@ static int blob_resize (struct blob *o, size_t size)
 	return 1;
 }
 
-int blob_write (struct blob *o, const char *data, size_t count)
+int blob_write (struct blob *o, const void *data, size_t count)
 {
-	const size_t next = o->count + count;
+	if (count == 0)
+		return 1;
 
-	if (next < o->count) {		/* size overflow */
-		errno = ENOMEM;
+	if (!blob_reserve (o, count))
 		return 0;
-	}
 
-	if (next > o->size && !blob_resize (o, next))
+	memcpy ((char *) o->data + o->count, data, count);
+	o->count += count;
+	return 1;
+}
+
+int blob_printf (struct blob *o, const char *fmt, ...)
+{
+	va_list ap;
+	int len;
+
+	va_start (ap, fmt);
+	len = vsnprintf ((char *) o->data + o->count, o->size - o->count,
+			 fmt, ap);
+	va_end (ap);
+
+	if (len < 0)
 		return 0;
 
-	memcpy (o->data + o->count, data, count);
-	o->count = next;
+	if ((size_t) len >= o->size - o->count) {  /* no room for all	*/
+		if (!blob_reserve (o, (size_t) len + 1))
+			return 0;
+
+		va_start (ap, fmt);
+		vsnprintf ((char *) o->data + o->count, o->size - o->count,
+			   fmt, ap);
+		va_end (ap);
+	}
+
+	o->count += len;
 	return 1;
 }
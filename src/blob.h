@@ -10,24 +10,50 @@
 #define BLOB_H  1
 
 #include <stddef.h>
+#include <stdlib.h>
+
+/*
+ * Short data lives in the inline buffer, thus a blob must not be copied
+ * or moved while in use
+ */
+#define BLOB_INLINE	128
 
 struct blob {
 	size_t count, size;	/* blob size and available space	*/
-	void *data;		/* blob data				*/
+	void *data;		/* blob data: inline buffer or heap	*/
+	char buf[BLOB_INLINE];	/* inline buffer for short data		*/
 };
 
 static inline void blob_init (struct blob *o)
 {
 	o->count = 0;
-	o->size  = 0;
-	o->data  = NULL;
+	o->size  = sizeof (o->buf);
+	o->data  = o->buf;
 }
 
 static inline void blob_fini (struct blob *o)
 {
-	free (o->data);
+	if (o->data != o->buf)
+		free (o->data);
 }
 
-int blob_write (struct blob *o, const char *data, size_t count);
+/* empties the blob and keeps the space available for reuse */
+static inline void blob_reset (struct blob *o)
+{
+	o->count = 0;
+}
+
+/*
+ * blob_reserve makes room for count more bytes. The space grows by half
+ * at least, thus a series of appends takes linear time.
+ *
+ * blob_write appends the data to the blob.
+ *
+ * blob_printf appends formatted text to the blob. The terminating NUL is
+ * stored after the text but is not counted.
+ */
+int blob_reserve (struct blob *o, size_t count);
+int blob_write   (struct blob *o, const void *data, size_t count);
+int blob_printf  (struct blob *o, const char *fmt, ...);
 
 #endif  /* BLOB_H*/
@@ -0,0 +1,477 @@
+/*
+ * CUPL Preprocessor Benchmark
+ *
+ * Copyright (c) 2025 Alexei A. Smekalkine <ikle@ikle.ru>
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <getopt.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "allocs.h"
+#include "cupl-fons.h"
+#include "patsub.h"
+
+#define ARRAY_SIZE(a)	(sizeof (a) / sizeof ((a)[0]))
+
+#define INCLUDES	100	/* depth of include nesting		*/
+#define DEFINES		20000	/* number of defines			*/
+#define LINES		20000	/* number of lines of ordinary corpora	*/
+
+/*
+ * Synthetic CUPL sources: every generator writes the main file and
+ * creates other files it needs in the directory dir
+ */
+static int gen_plain (FILE *f, const char *dir)
+{
+	size_t i;
+
+	for (i = 0; i < LINES; ++i)
+		fprintf (f, "Q%zu.d = A%zu & B%zu # !C%zu & Q%zu;\n",
+			 i, i % 8, i % 16, i % 32, i);
+
+	return 1;
+}
+
+static int gen_include (FILE *f, const char *dir)
+{
+	char path[256];
+	size_t i, j;
+	FILE *inc;
+
+	for (i = 0; i < INCLUDES; ++i) {
+		snprintf (path, sizeof (path), "%s/inc%zu.h", dir, i);
+
+		if ((inc = fopen (path, "w")) == NULL)
+			return 0;
+
+		if (i + 1 < INCLUDES)
+			fprintf (inc, "$include %s/inc%zu.h\n", dir, i + 1);
+
+		fprintf (inc, "$define L%zu D%zu\n", i, i);
+
+		for (j = 0; j < LINES / INCLUDES; ++j)
+			fprintf (inc, "Q%zu.d = L%zu & A%zu;\n", j, i, j % 8);
+
+		if (fclose (inc) != 0)
+			return 0;
+	}
+
+	fprintf (f, "$include %s/inc0.h\n", dir);
+
+	for (i = 0; i < LINES / INCLUDES; ++i)
+		fprintf (f, "Q%zu.d = L%zu & B%zu;\n", i, i, i % 8);
+
+	return 1;
+}
+
+static int gen_defines (FILE *f, const char *dir)
+{
+	size_t i;
+
+	for (i = 0; i < DEFINES; ++i)
+		fprintf (f, "$define N%zu V%zu\n", i, i * 7);
+
+	for (i = 0; i < LINES; ++i)
+		fprintf (f, "Q%zu.d = N%zu & N%zu # X%zu;\n",
+			 i, i, (i * 31) % DEFINES, i);
+
+	return 1;
+}
+
+static int gen_longline (FILE *f, const char *dir)
+{
+	size_t i, j;
+
+	for (i = 0; i < 256; ++i)
+		fprintf (f, "$define N%zu V%zu\n", i, i);
+
+	for (i = 0; i < 16; ++i) {
+		fprintf (f, "F%zu = ", i);
+
+		for (j = 0; j < 16384; ++j)
+			fprintf (f, "N%zu & Q%zu # ", (i + j) % 256, j);
+
+		fprintf (f, "0;\n");
+	}
+
+	return 1;
+}
+
+static int gen_pins (FILE *f, const char *dir)
+{
+	size_t i;
+
+	fprintf (f, "$define CLK 1\n$define OE 2\n$define RST 3\n");
+
+	for (i = 0; i < LINES; ++i)
+		fprintf (f, "PIN [%zu..%zu] = [Q0..Q7, CLK, OE, RST];\n",
+			 i % 64, i % 64 + 7);
+
+	return 1;
+}
+
+static int gen_repeat (FILE *f, const char *dir)
+{
+	fprintf (f, "$define EN 1\n"
+		    "$repeat i = [0..%d]\n"
+		    "Q{i}.d = Q{i-1} & EN # D{i*2};\n"
+		    "Q{i}.oe = OE;\n"
+		    "$repend\n", LINES / 2 - 1);
+	return 1;
+}
+
+static const struct corpus {
+	const char *name;
+	int (*gen) (FILE *f, const char *dir);
+} corpora[] = {
+	{ "plain",	gen_plain	},
+	{ "include",	gen_include	},
+	{ "defines",	gen_defines	},
+	{ "longline",	gen_longline	},
+	{ "pins",	gen_pins	},
+	{ "repeat",	gen_repeat	},
+};
+
+/*
+ * Benchmark runner: every operation reports the number of bytes and lines
+ * processed
+ */
+struct bench {
+	const char *corpus, *path;
+	size_t bytes, lines;
+
+	struct patset P;	/* defines for pattern stages		*/
+	char *text;		/* source string for pattern stages	*/
+};
+
+static uint64_t now (void)
+{
+	struct timespec ts;
+
+	clock_gettime (CLOCK_MONOTONIC, &ts);
+	return (uint64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static int op_fons (struct bench *o)
+{
+	const struct fons_line *line;
+	struct fons in;
+
+	if (!fons_init (&in, o->path))
+		return 0;
+
+	for (o->bytes = o->lines = 0; (line = fons_read (&in)) != NULL; ++o->lines)
+		o->bytes += line->count;
+
+	fons_fini (&in);
+	return errno == 0;
+}
+
+static int op_cupl (struct bench *o)
+{
+	const struct fons_line *line;
+	struct cupl_fons in;
+	int ok;
+
+	if (!cupl_fons_init (&in, o->path))
+		return 0;
+
+	for (o->bytes = o->lines = 0; (line = cupl_fons_read (&in)) != NULL; ++o->lines)
+		o->bytes += line->count;
+
+	ok = errno == 0 && in.error == NULL;
+
+	cupl_fons_fini (&in);
+	return ok;
+}
+
+static int op_patset (struct bench *o)
+{
+	struct patset P;
+	char name[32], value[32];
+	size_t i;
+	int ok = 1;
+
+	patset_init (&P);
+
+	for (i = 0, o->bytes = 0; ok && i < DEFINES; ++i) {
+		o->bytes += snprintf (name,  sizeof (name),  "N%zu", i);
+		snprintf (value, sizeof (value), "V%zu", i);
+
+		ok = patset_add (&P, name, value);
+	}
+
+	for (i = 0; ok && i < DEFINES; ++i) {
+		snprintf (name, sizeof (name), "N%zu", (i * 31) % DEFINES);
+
+		ok = patset_find (&P, name) != NULL;
+	}
+
+	o->lines = DEFINES;
+	patset_fini (&P);
+	return ok;
+}
+
+static int op_patsub (struct bench *o)
+{
+	struct patsub s;
+	int ok;
+
+	patsub_init (&s, &o->P);
+
+	ok = patsub_apply (&s, o->text);
+	o->bytes = strlen (o->text);
+	o->lines = 1;
+
+	patsub_fini (&s);
+	return ok;
+}
+
+static const struct op {
+	const char *name;
+	int (*fn) (struct bench *o);
+	int source;		/* runs over source corpora		*/
+} ops[] = {
+	{ "fons",	op_fons,	1 },
+	{ "cupl",	op_cupl,	1 },
+	{ "patset",	op_patset,	0 },
+	{ "patsub",	op_patsub,	0 },
+};
+
+static int u64_cmp (const void *a, const void *b)
+{
+	const uint64_t *l = a, *r = b;
+
+	return *l < *r ? -1 : *l > *r;
+}
+
+static long peak_rss (void)
+{
+	struct rusage ru;
+
+	return getrusage (RUSAGE_SELF, &ru) == 0 ? ru.ru_maxrss : -1;
+}
+
+static int measure (struct bench *o, const struct op *op, size_t warmup,
+		    size_t iters, uint64_t *t)
+{
+	size_t i, count;
+	uint64_t start, median;
+
+	for (i = 0; i < warmup; ++i)
+		if (!op->fn (o))
+			return 0;
+
+	count = allocs;
+
+	for (i = 0; i < iters; ++i) {
+		start = now ();
+
+		if (!op->fn (o))
+			return 0;
+
+		t[i] = now () - start;
+	}
+
+	count = allocs - count;
+	qsort (t, iters, sizeof (t[0]), u64_cmp);
+	median = t[iters / 2] > 0 ? t[iters / 2] : 1;
+
+	printf ("%s,%s,%zu,%zu,%zu,%llu,%llu,%.1f,%.0f,%.1f,%ld\n",
+		op->name, o->corpus, iters, o->bytes, o->lines,
+		(unsigned long long) t[0], (unsigned long long) median,
+		o->bytes * 1e3 / median, o->lines * 1e9 / median,
+		(double) count / iters, peak_rss ());
+	return 1;
+}
+
+/*
+ * Every stage runs in a child process of its own, thus the peak RSS it
+ * reports is not hidden by the peaks of the stages before it
+ */
+static int run (struct bench *o, const struct op *op, size_t warmup,
+		size_t iters, uint64_t *t)
+{
+	pid_t pid;
+	int status;
+
+	if (fflush (stdout) != 0 || (pid = fork ()) < 0)
+		return 0;
+
+	if (pid == 0) {
+		status = measure (o, op, warmup, iters, t);
+		status = fflush (stdout) == 0 && status;
+		_exit (status ? 0 : 1);
+	}
+
+	return waitpid (pid, &status, 0) == pid && WIFEXITED (status) &&
+	       WEXITSTATUS (status) == 0;
+}
+
+/*
+ * Pattern stages run over the longline corpus text with its defines
+ */
+static int make_patterns (struct bench *o)
+{
+	char name[32], value[32];
+	size_t i, j, len = 0;
+
+	patset_init (&o->P);
+
+	for (i = 0; i < 256; ++i) {
+		snprintf (name,  sizeof (name),  "N%zu", i);
+		snprintf (value, sizeof (value), "V%zu", i);
+
+		if (!patset_add (&o->P, name, value))
+			return 0;
+	}
+
+	if ((o->text = malloc (16384 * 32)) == NULL)
+		return 0;
+
+	for (j = 0; j < 16384; ++j)
+		len += sprintf (o->text + len, "N%zu & Q%zu # ", j % 256, j);
+
+	return 1;
+}
+
+static FILE *make_file (const char *dir, const char *name, char **path)
+{
+	const size_t len = strlen (dir) + strlen (name) + 6;
+	FILE *f;
+
+	if ((*path = malloc (len)) == NULL)
+		return NULL;
+
+	snprintf (*path, len, "%s/%s.pld", dir, name);
+
+	if ((f = fopen (*path, "w")) == NULL)
+		free (*path);
+
+	return f;
+}
+
+static int bench (struct bench *o, const struct corpus *c, const char *dir,
+		  size_t warmup, size_t iters, uint64_t *t)
+{
+	char *path;
+	size_t i;
+	FILE *f;
+	int ok = 1;
+
+	if ((f = make_file (dir, c->name, &path)) == NULL)
+		goto no_file;
+
+	ok = c->gen (f, dir);
+	ok = fclose (f) == 0 && ok;
+
+	if (!ok)
+		goto no_gen;
+
+	o->corpus = c->name;
+	o->path   = path;
+
+	for (i = 0; i < ARRAY_SIZE (ops); ++i)
+		if (ops[i].source && !run (o, ops + i, warmup, iters, t)) {
+			fprintf (stderr, "E: %s: %s failed\n", ops[i].name,
+				 c->name);
+			ok = 0;
+		}
+
+	free (path);
+	return ok;
+no_gen:
+	free (path);
+no_file:
+	perror ("E");
+	return 0;
+}
+
+static void remove_files (const char *dir)
+{
+	char path[256];
+	size_t i;
+
+	for (i = 0; i < INCLUDES; ++i) {
+		snprintf (path, sizeof (path), "%s/inc%zu.h", dir, i);
+		unlink (path);
+	}
+
+	for (i = 0; i < ARRAY_SIZE (corpora); ++i) {
+		snprintf (path, sizeof (path), "%s/%s.pld", dir, corpora[i].name);
+		unlink (path);
+	}
+
+	rmdir (dir);
+}
+
+static int usage (void)
+{
+	fprintf (stderr, "usage:\n"
+			 "\tcupl-bench [-w <warmup>] [-n <iterations>]\n"
+			 "\n"
+			 "Prints CSV: times in nanoseconds, throughput in MB/s and\n"
+			 "lines/s, allocations per operation, peak RSS in KiB.\n"
+			 "Every stage runs in a process of its own, thus its peak\n"
+			 "RSS adds to the baseline of the benchmark only.\n");
+	return 1;
+}
+
+int main (int argc, char *argv[])
+{
+	size_t warmup = 2, iters = 10, i;
+	struct bench o = { NULL };
+	const char *tmp;
+	char dir[256];
+	uint64_t *t;
+	int opt, ok = 1;
+
+	while ((opt = getopt (argc, argv, "w:n:")) != -1)
+		switch (opt) {
+		case 'w':	warmup = strtoul (optarg, NULL, 0);	break;
+		case 'n':	iters  = strtoul (optarg, NULL, 0);	break;
+		default:	return usage ();
+		}
+
+	if (iters == 0 || (t = malloc (iters * sizeof (t[0]))) == NULL)
+		return usage ();
+
+	if ((tmp = getenv ("TMPDIR")) == NULL)
+		tmp = "/tmp";
+
+	snprintf (dir, sizeof (dir), "%s/cupl-bench-XXXXXX", tmp);
+
+	if (mkdtemp (dir) == NULL || !make_patterns (&o)) {
+		perror ("E");
+		return 1;
+	}
+
+	printf ("stage,corpus,iters,bytes,lines,min_ns,median_ns,"
+		"mb_per_s,lines_per_s,allocs_per_op,peak_rss_kb\n");
+
+	for (i = 0; i < ARRAY_SIZE (corpora); ++i)
+		ok &= bench (&o, corpora + i, dir, warmup, iters, t);
+
+	o.corpus = "synthetic";
+
+	for (i = 0; i < ARRAY_SIZE (ops); ++i)
+		if (!ops[i].source && !run (&o, ops + i, warmup, iters, t)) {
+			fprintf (stderr, "E: %s failed\n", ops[i].name);
+			ok = 0;
+		}
+
+	remove_files (dir);
+	free (o.text);
+	patset_fini (&o.P);
+	free (t);
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,261 @@
+/*
+ * CUPL Preprocessor Test
+ *
+ * Copyright (c) 2025 Alexei A. Smekalkine <ikle@ikle.ru>
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cupl-fons.h"
+
+#define SOURCE	"cupl-fons-test.pld"
+#define HEADER	"cupl-fons-test.h"
+#define ODD	"cupl fons#test$.pld"	/* name to escape for make	*/
+
+static const struct test {
+	const char *name;
+	const char *source;
+	const char *output;	/* expected output			*/
+	const char *error;	/* expected error or NULL		*/
+} tests[] = {
+	{
+		"nested conditionals",
+		"$define A 1\n"
+		"$ifdef B\n"
+		"$ifdef A\n"
+		"no1\n"
+		"$else\n"
+		"no2\n"
+		"$endif\n"
+		"$ifndef A\n"
+		"no3\n"
+		"$else\n"
+		"no4\n"
+		"$endif\n"
+		"$bogus directive is not parsed\n"
+		"$else\n"
+		"yes A\n"
+		"$ifndef B\n"
+		"yes2\n"
+		"$else\n"
+		"no5\n"
+		"$endif\n"
+		"$endif\n"
+		"$undef A\n"
+		"$ifdef A\n"
+		"no6\n"
+		"$endif\n",
+		"yes 1\nyes2\n",
+		NULL,
+	},
+	{
+		"define on identifier boundaries",
+		"$define FOO bar\n"
+		"FOO FOOD xFOO (FOO)FOO\n"
+		"FOO_1 _FOO FOO;\n",
+		"bar FOOD xFOO (bar)bar\n"
+		"FOO_1 _FOO bar;\n",
+		NULL,
+	},
+	{
+		"nested repeats",
+		"$repeat i = [0..1, 5]\n"
+		"a{i}\n"
+		"$repeat j = [3..1, 7]\n"
+		"b{i}{j} {i*10+j}\n"
+		"$repend\n"
+		"$repend\n",
+		"a0\nb03 3\nb02 2\nb01 1\nb07 7\n"
+		"a1\nb13 13\nb12 12\nb11 11\nb17 17\n"
+		"a5\nb53 53\nb52 52\nb51 51\nb57 57\n",
+		NULL,
+	},
+	{
+		"include from repeat",
+		"$repeat i = [2..1]\n"
+		"pre{i}\n"
+		"$include " HEADER "\n"
+		"post{i}\n"
+		"$repend\n",
+		"pre2\nheader {i}\npost2\npre1\nheader {i}\npost1\n",
+		NULL,
+	},
+	{
+		"macro call",
+		"$macro m a b;\n"
+		"a = b;\n"
+		"x{a} = {b};\n"
+		"$mend\n"
+		"m (Q, f (x, (y, z)));\n"
+		"m(R,1)\n",
+		"Q = f (x, (y, z));\nxQ = f (x, (y, z));\nR = 1;\nxR = 1;\n",
+		NULL,
+	},
+	{
+		"too many macro arguments",
+		"$macro m a\n$mend\nm (1, 2);\n",
+		"",
+		"Too many arguments for macro call",
+	},
+	{
+		"too few macro arguments",
+		"$macro m a b\n$mend\nm (1);\n",
+		"",
+		"Too few arguments for macro call",
+	},
+	{
+		"recursive macro",
+		"$macro R n\nR (n);\n$mend\nR (x);\n",
+		"",
+		"Macro nesting too deep",
+	},
+	{
+		"unterminated repeat",
+		"$repeat i = [0..2]\nq{i}\n",
+		"",
+		"Unterminated repeat directive",
+	},
+	{
+		"unterminated macro",
+		"$macro m a\na\n",
+		"",
+		"Unterminated macro directive",
+	},
+	{
+		"unterminated conditional",
+		"$ifdef A\n$else\nq\n",
+		"q\n",
+		"Unterminated conditional directive",
+	},
+	{
+		"recursive include",
+		"$include " SOURCE "\n",
+		"",
+		"Include nesting too deep",
+	},
+	{
+		"arithmetic overflow",
+		"$repeat i = [1]\n{(0-9223372036854775807-1)%-1}\n$repend\n",
+		"",
+		"Arithmetic overflow in brace expression",
+	},
+};
+
+static int write_file (const char *path, const char *data)
+{
+	FILE *f;
+	int ok;
+
+	if ((f = fopen (path, "w")) == NULL)
+		return 0;
+
+	ok = fputs (data, f) >= 0;
+	return fclose (f) == 0 && ok;
+}
+
+static int run (const struct test *t)
+{
+	struct cupl_fons in;
+	const struct fons_line *line;
+	struct blob out;
+	int ok;
+
+	if (!write_file (SOURCE, t->source) || !cupl_fons_init (&in, SOURCE)) {
+		perror ("E: " SOURCE);
+		return 0;
+	}
+
+	blob_init (&out);
+
+	while ((line = cupl_fons_read (&in)) != NULL)
+		if (!blob_write (&out, line->data, line->count))
+			break;
+
+	ok = out.count == strlen (t->output) &&
+	     memcmp (out.data, t->output, out.count) == 0;
+
+	if (!ok)
+		fprintf (stderr, "E: %s: got output:\n%.*s", t->name,
+			 (int) out.count, (const char *) out.data);
+
+	if (t->error == NULL ? in.error != NULL || errno != 0 :
+	    in.error == NULL || strcmp (in.error, t->error) != 0) {
+		fprintf (stderr, "E: %s: got error: %s\n", t->name,
+			 in.error != NULL ? in.error : strerror (errno));
+		ok = 0;
+	}
+
+	blob_fini (&out);
+	cupl_fons_fini (&in);
+	return ok;
+}
+
+/*
+ * The make rule lists every file once, escapes names, and has empty rules
+ * for included files
+ */
+static int check_rule (void)
+{
+	static const char *rule =
+		"out\\ put\\#$$.jed: cupl\\ fons\\#test$$.pld " HEADER "\n"
+		"\n" HEADER ":\n";
+	struct cupl_fons in;
+	const struct fons_line *line;
+	struct blob out;
+	const char *p;
+	int ok;
+
+	if (!write_file (ODD, "$include " HEADER "\n$include " HEADER "\n") ||
+	    !cupl_fons_init (&in, ODD)) {
+		perror ("E: " ODD);
+		return 0;
+	}
+
+	blob_init (&out);
+
+	while ((line = cupl_fons_read (&in)) != NULL) {}
+
+	ok = errno == 0 && in.error == NULL &&
+	     fons_rule (&in.in, "out put#$.jed", &out) &&
+	     blob_write (&out, "", 1) &&
+	     strncmp (out.data, "# hash ", 7) == 0 &&
+	     (p = strchr (out.data, '\n')) != NULL && p - (char *) out.data == 23 &&
+	     strcmp (p + 1, rule) == 0;
+
+	if (!ok)
+		fprintf (stderr, "E: make rule: got:\n%.*s\n",
+			 (int) out.count, (const char *) out.data);
+
+	blob_fini (&out);
+	cupl_fons_fini (&in);
+	remove (ODD);
+	return ok;
+}
+
+int main (int argc, char *argv[])
+{
+	const size_t n = sizeof (tests) / sizeof (tests[0]);
+	size_t i, passed = 0;
+	int ok;
+
+	if (!write_file (HEADER, "header {i}\n")) {
+		perror ("E: " HEADER);
+		return 1;
+	}
+
+	for (i = 0; i < n; ++i)
+		passed += run (tests + i);
+
+	printf ("I: %zu of %zu preprocessor tests passed\n", passed, n);
+
+	ok = check_rule ();
+	printf ("I: make rule %s\n", ok ? "ok" : "failed");
+
+	remove (SOURCE);
+	remove (HEADER);
+	return passed == n && ok ? 0 : 1;
+}
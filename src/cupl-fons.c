@@ -7,45 +7,142 @@
  */
 
 #include <ctype.h>
+#include <limits.h>
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <strings.h>
 
 #include "cupl-fons.h"
 
+/*
+ * Generators replay recorded bodies: the body of a repeat once for every
+ * index value, the body of a macro once. A generator is read only while
+ * the file it was started from is on the top of the source stack, thus
+ * files included from a body go first.
+ */
+#define CUPL_GEN_MAX	256	/* limit of nested generators		*/
+#define CUPL_INCLUDE_MAX 256	/* limit of nested included files	*/
+
+struct cupl_range {
+	long from, to;
+};
+
+struct cupl_gen {
+	struct cupl_gen *next;
+	const struct fons_input *input;	/* file the generator started from */
+	struct blob body;	/* recorded body of repeat		*/
+	const char *data;	/* lines to replay			*/
+	size_t size, pos;	/* their size and offset of the next line */
+	struct patset args;	/* bound arguments			*/
+
+	char *index;		/* repeat index name, NULL for macro	*/
+	struct blob range;	/* repeat index ranges			*/
+	size_t r;		/* current range or pass number		*/
+	long value;		/* next index value			*/
+};
+
+struct cupl_macro {
+	struct cupl_macro *next;
+	struct blob args;	/* NUL-terminated name and arguments	*/
+	size_t argc;
+	struct blob body;	/* recorded body			*/
+};
+
+static struct cupl_gen *gen_alloc (void)
+{
+	struct cupl_gen *g;
+
+	if ((g = calloc (1, sizeof (*g))) == NULL)
+		return NULL;
+
+	blob_init (&g->body);
+	patset_init (&g->args);
+	blob_init (&g->range);
+	return g;
+}
+
+static void gen_free (struct cupl_gen *g)
+{
+	blob_fini (&g->range);
+	free (g->index);
+	patset_fini (&g->args);
+	blob_fini (&g->body);
+	free (g);
+}
+
+static void gen_push (struct cupl_fons *o, struct cupl_gen *g, const char *data,
+		      size_t size)
+{
+	g->input = o->in.input;
+	g->data  = data;
+	g->size  = size;
+	g->pos   = size;		/* start the first pass on read	*/
+	g->next  = o->gen;
+	o->gen   = g;
+	++o->depth;
+}
+
+static void macro_free (struct cupl_macro *m)
+{
+	blob_fini (&m->body);
+	blob_fini (&m->args);
+	free (m);
+}
+
 int cupl_fons_init (struct cupl_fons *o, const char *path)
 {
 	if (!fons_init (&o->in, path))
 		return 0;
 
 	patset_init (&o->vars);
+	spans_init (&o->out);
 	blob_init (&o->line);
+	blob_init (&o->cmd);
+	blob_init (&o->bound);
+	o->gen   = NULL;
+	o->depth = 0;
+	o->macro = NULL;
+	o->level = 0;
+	o->skip  = 0;
 	o->error = NULL;
 	return 1;
 }
 
 void cupl_fons_fini (struct cupl_fons *o)
 {
+	struct cupl_gen *g;
+	struct cupl_macro *m;
+
+	while ((g = o->gen) != NULL) {
+		o->gen = g->next;
+		gen_free (g);
+	}
+
+	while ((m = o->macro) != NULL) {
+		o->macro = m->next;
+		macro_free (m);
+	}
+
+	blob_fini (&o->bound);
+	blob_fini (&o->cmd);
 	blob_fini (&o->line);
+	spans_fini (&o->out);
 	patset_fini (&o->vars);
 	fons_fini (&o->in);
 }
 
-static int match_keyword (const struct blob *o, size_t i, const char *name)
-{
-	return strncasecmp (o->data + i, name, o->count - i) == 0;
-}
-
 static int isword (int a)
 {
 	return a == '_' || isalnum (a);
 }
 
 #define DEFINE_SKIP(type)						\
-static size_t skip_##type (const struct blob *o, size_t i)		\
+static size_t skip_##type (const struct fons_line *o, size_t i)	\
 {									\
 	const char *s = o->data;					\
 									\
-	for (; i < o->count && is##type (s[i]); ++i) {}			\
+	for (; i < o->count && is##type ((unsigned char) s[i]); ++i) {}	\
 									\
 	return i;							\
 }
@@ -54,9 +151,475 @@ DEFINE_SKIP (space)
 DEFINE_SKIP (graph)
 DEFINE_SKIP (word)
 
-static int do_include (struct cupl_fons *o, struct blob *line, size_t s)
+enum cupl_dir {
+	DIR_TEXT,		/* not a directive			*/
+	DIR_UNKNOWN,
+	DIR_DEFINE,
+	DIR_UNDEF,
+	DIR_INCLUDE,
+	DIR_IFDEF,
+	DIR_IFNDEF,
+	DIR_ELSE,
+	DIR_ENDIF,
+	DIR_REPEAT,
+	DIR_REPEND,
+	DIR_MACRO,
+	DIR_MEND,
+};
+
+static int is_name (const char *s, size_t len, const char *name)
+{
+	return strncasecmp (s, name, len) == 0 && name[len] == '\0';
+}
+
+/*
+ * Recognizes the directive at position i of the line and returns the end
+ * of its name: dispatches on the first letter of the name, then compares
+ * with a few candidates at most
+ */
+static enum cupl_dir
+directive (const struct fons_line *o, size_t i, size_t *end)
+{
+	const char *s = o->data + i + 1;
+	size_t len;
+
+	if (i >= o->count || o->data[i] != '$')
+		return DIR_TEXT;
+
+	*end = skip_word (o, i + 1);
+	len  = *end - i - 1;
+
+	switch (len > 0 ? tolower ((unsigned char) s[0]) : 0) {
+	case 'd':
+		if (is_name (s, len, "define"))		return DIR_DEFINE;
+		break;
+	case 'e':
+		if (is_name (s, len, "else"))		return DIR_ELSE;
+		if (is_name (s, len, "endif"))		return DIR_ENDIF;
+		break;
+	case 'i':
+		if (is_name (s, len, "include"))	return DIR_INCLUDE;
+		if (is_name (s, len, "ifdef"))		return DIR_IFDEF;
+		if (is_name (s, len, "ifndef"))		return DIR_IFNDEF;
+		break;
+	case 'm':
+		if (is_name (s, len, "macro"))		return DIR_MACRO;
+		if (is_name (s, len, "mend"))		return DIR_MEND;
+		break;
+	case 'r':
+		if (is_name (s, len, "repeat"))		return DIR_REPEAT;
+		if (is_name (s, len, "repend"))		return DIR_REPEND;
+		break;
+	case 'u':
+		if (is_name (s, len, "undef"))		return DIR_UNDEF;
+		break;
+	}
+
+	return DIR_UNKNOWN;
+}
+
+/*
+ * Arguments in braces: a bound name gives its value, other expressions
+ * are evaluated over integers with bound names as variables
+ */
+struct cupl_expr {
+	struct cupl_gen *gen;
+	const char *s, *e;
+	const char *error;	/* set on arithmetic overflow		*/
+};
+
+static const struct pattern *
+gen_lookup (struct cupl_gen *g, const char *name, size_t len)
+{
+	const struct pattern *p;
+
+	for (; g != NULL; g = g->next)
+		if ((p = patset_lookup (&g->args, name, len)) != NULL)
+			return p;
+
+	return NULL;
+}
+
+static int expr_overflow (struct cupl_expr *x)
+{
+	x->error = "Arithmetic overflow in brace expression";
+	return 0;
+}
+
+static void expr_space (struct cupl_expr *x)
+{
+	for (; x->s < x->e && isspace ((unsigned char) *x->s); ++x->s) {}
+}
+
+static int expr_is (struct cupl_expr *x, const char *op)
+{
+	const size_t len = strlen (op);
+
+	expr_space (x);
+
+	if (x->e - x->s < len || memcmp (x->s, op, len) != 0)
+		return 0;
+
+	x->s += len;
+	return 1;
+}
+
+static int expr_sum (struct cupl_expr *x, long *v);
+
+static int expr_atom (struct cupl_expr *x, long *v)
+{
+	const struct pattern *p;
+	const char *s;
+	char *end;
+
+	if (expr_is (x, "("))
+		return expr_sum (x, v) && expr_is (x, ")");
+
+	if (expr_is (x, "-")) {
+		if (!expr_atom (x, v))
+			return 0;
+
+		if (__builtin_sub_overflow (0, *v, v))
+			return expr_overflow (x);
+
+		return 1;
+	}
+
+	for (s = x->s; x->s < x->e && isword ((unsigned char) *x->s); ++x->s) {}
+
+	if (s == x->s)
+		return 0;
+
+	if (isdigit ((unsigned char) *s)) {
+		for (*v = 0; s < x->s; ++s)
+			if (!isdigit ((unsigned char) *s))
+				return 0;
+			else if (__builtin_mul_overflow (*v, 10, v) ||
+				 __builtin_add_overflow (*v, *s - '0', v))
+				return expr_overflow (x);
+
+		return 1;
+	}
+
+	if ((p = gen_lookup (x->gen, s, x->s - s)) == NULL || p->vlen == 0)
+		return 0;
+
+	errno = 0;
+	*v = strtol (p->value, &end, 10);
+
+	if (*end != '\0')
+		return 0;
+
+	return errno == 0 ? 1 : expr_overflow (x);
+}
+
+static int expr_power (struct cupl_expr *x, long *v)
+{
+	long e, b;
+
+	if (!expr_atom (x, v))
+		return 0;
+
+	if (!expr_is (x, "**"))
+		return 1;
+
+	if (!expr_power (x, &e) || e < 0)
+		return 0;
+
+	if ((b = *v) >= -1 && b <= 1) {		/* no overflow, no loop	*/
+		*v = b == -1 && (e & 1) == 0 ? 1 : e == 0 ? 1 : b;
+		return 1;
+	}
+
+	for (*v = 1; e > 0; --e)
+		if (__builtin_mul_overflow (*v, b, v))
+			return expr_overflow (x);
+
+	return 1;
+}
+
+static int expr_product (struct cupl_expr *x, long *v)
+{
+	long r;
+	int op;
+
+	if (!expr_power (x, v))
+		return 0;
+
+	for (;;) {
+		if (expr_is (x, "*"))		op = '*';
+		else if (expr_is (x, "/"))	op = '/';
+		else if (expr_is (x, "%"))	op = '%';
+		else				return 1;
+
+		if (!expr_power (x, &r) || (op != '*' && r == 0))
+			return 0;
+
+		if (op == '*') {
+			if (__builtin_mul_overflow (*v, r, v))
+				return expr_overflow (x);
+
+			continue;
+		}
+
+		if (*v == LONG_MIN && r == -1)	/* traps for / and %	*/
+			return expr_overflow (x);
+
+		*v = op == '/' ? *v / r : *v % r;
+	}
+}
+
+static int expr_sum (struct cupl_expr *x, long *v)
+{
+	long r;
+	int op;
+
+	if (!expr_product (x, v))
+		return 0;
+
+	for (;;) {
+		if (expr_is (x, "+"))		op = '+';
+		else if (expr_is (x, "-"))	op = '-';
+		else				return 1;
+
+		if (!expr_product (x, &r))
+			return 0;
+
+		if (op == '+' ? __builtin_add_overflow (*v, r, v) :
+				__builtin_sub_overflow (*v, r, v))
+			return expr_overflow (x);
+	}
+}
+
+/*
+ * Writes the value of the braces content [s, e) into the bound line,
+ * returns zero with errno zero if it is not an argument expression. On
+ * arithmetic overflow sets the error and errno to EINVAL.
+ */
+static int bind_brace (struct cupl_fons *o, const char *s, const char *e)
+{
+	struct cupl_expr x = { o->gen, s, e, NULL };
+	const struct pattern *p;
+	long v;
+
+	for (; s < e && isspace ((unsigned char) *s); ++s) {}
+	for (; e > s && isspace ((unsigned char) e[-1]); --e) {}
+
+	for (x.s = s; x.s < e && isword ((unsigned char) *x.s); ++x.s) {}
+
+	if (x.s == e && s < e && (p = gen_lookup (o->gen, s, e - s)) != NULL)
+		return blob_write (&o->bound, p->value, p->vlen);
+
+	x.s = s;
+
+	if (!expr_sum (&x, &v) || (expr_space (&x), x.s != x.e)) {
+		if (x.error != NULL) {
+			o->error = x.error;
+			errno = EINVAL;
+			return 0;
+		}
+
+		errno = 0;
+		return 0;
+	}
+
+	return blob_printf (&o->bound, "%ld", v);
+}
+
+/*
+ * Binds arguments of the line of the top generator: expressions in braces
+ * and, for macros, identifiers that name arguments
+ */
+static const struct fons_line *
+gen_bind (struct cupl_fons *o, const char *s, size_t len)
+{
+	const struct fons_line line = { s, len };
+	struct cupl_gen *g = o->gen;
+	const int words = g->index == NULL && g->args.count > 0;
+	const struct pattern *p;
+	const char *close;
+	size_t i, e, at, mark;
+
+	o->text = line;
+
+	if (!words && memchr (s, '{', len) == NULL)
+		return &o->text;
+
+	blob_reset (&o->bound);
+
+	for (i = 0, at = 0; i < len; i = e) {
+		if (s[i] == '{' &&
+		    (close = memchr (s + i, '}', len - i)) != NULL) {
+			e = close - s + 1;
+
+			if (!blob_write (&o->bound, s + at, i - at))
+				return NULL;
+
+			mark = o->bound.count;
+
+			if (bind_brace (o, s + i + 1, close)) {
+				at = e;
+				continue;
+			}
+
+			if (errno != 0)
+				return NULL;
+
+			o->bound.count = mark - (i - at);  /* not bound	*/
+			e = i + 1;
+			continue;
+		}
+
+		if (!words || !isword ((unsigned char) s[i])) {
+			e = i + 1;
+			continue;
+		}
+
+		e = skip_word (&line, i);
+
+		if ((p = patset_lookup (&g->args, s + i, e - i)) == NULL)
+			continue;
+
+		if (!blob_write (&o->bound, s + at, i - at) ||
+		    !blob_write (&o->bound, p->value, p->vlen))
+			return NULL;
+
+		at = e;
+	}
+
+	if (!blob_write (&o->bound, s + at, len - at))
+		return NULL;
+
+	o->text.data  = o->bound.data;
+	o->text.count = o->bound.count;
+	return &o->text;
+}
+
+/*
+ * Starts the next pass of the generator: binds the next index value of
+ * repeat. Returns zero with errno zero if there are no passes left.
+ */
+static int gen_rewind (struct cupl_gen *g)
+{
+	const struct cupl_range *r = g->range.data;
+	const size_t count = g->range.count / sizeof (r[0]);
+	char value[24];
+
+	if (g->index == NULL) {
+		errno = 0;
+		return g->r++ == 0 ? (g->pos = 0, 1) : 0;
+	}
+
+	if (g->r >= count) {
+		errno = 0;
+		return 0;
+	}
+
+	snprintf (value, sizeof (value), "%ld", g->value);
+
+	if (!patset_add (&g->args, g->index, value))
+		return 0;
+
+	if (g->value != r[g->r].to)
+		g->value += r[g->r].from < r[g->r].to ? 1 : -1;
+	else if (++g->r < count)
+		g->value = r[g->r].from;
+
+	g->pos = 0;
+	return 1;
+}
+
+static const struct fons_line *gen_read (struct cupl_fons *o)
+{
+	struct cupl_gen *g = o->gen;
+	const char *s, *e;
+	size_t avail;
+
+	while (g->pos >= g->size)
+		if (!gen_rewind (g))
+			return NULL;
+
+	s = g->data + g->pos;
+	avail = g->size - g->pos;
+	e = memchr (s, '\n', avail);
+
+	avail = e == NULL ? avail : e - s + 1;
+	g->pos += avail;
+	return gen_bind (o, s, avail);
+}
+
+/*
+ * Returns the next source line: from the innermost generator while its
+ * file is on the top of the source stack, from the top file otherwise
+ */
+static const struct fons_line *next_line (struct cupl_fons *o)
+{
+	const struct fons_line *line;
+	struct cupl_gen *g;
+
+	for (;;) {
+		if ((g = o->gen) != NULL && g->input == o->in.input) {
+			if ((line = gen_read (o)) != NULL || errno != 0)
+				return line;
+
+			o->gen = g->next;
+			--o->depth;
+			gen_free (g);
+			continue;
+		}
+
+		if ((line = fons_next (&o->in)) != NULL || errno != 0 ||
+		    o->in.input == NULL)
+			return line;
+
+		fons_pop (&o->in);
+	}
+}
+
+/*
+ * Records lines up to the directive that closes the body, nested bodies
+ * of the same kind included
+ */
+static int record (struct cupl_fons *o, struct blob *body, enum cupl_dir open,
+		   enum cupl_dir close)
+{
+	const struct fons_line *line;
+	enum cupl_dir d;
+	size_t depth = 1, e;
+
+	for (;;) {
+		if ((line = next_line (o)) == NULL) {
+			if (errno == 0)
+				o->error = close == DIR_REPEND ?
+					   "Unterminated repeat directive" :
+					   "Unterminated macro directive";
+			return 0;
+		}
+
+		d = directive (line, skip_space (line, 0), &e);
+
+		if (d == open)
+			++depth;
+		else if (d == close && --depth == 0)
+			return 1;
+
+		if (!blob_write (body, line->data, line->count))
+			return 0;
+
+		if ((line->count == 0 || line->data[line->count - 1] != '\n') &&
+		    !blob_write (body, "\n", 1))
+			return 0;
+	}
+}
+
+/*
+ * Directive handlers parse the line copy and cut it into NUL-terminated
+ * arguments
+ */
+static int do_include (struct cupl_fons *o, size_t s)
 {
-	char *p = line->data;
+	const struct fons_line *line = &o->view;
+	char *p = o->cmd.data;
 	const size_t ps = skip_space (line, s);		/* path start	*/
 	const size_t pe = skip_graph (line, ps);
 	const size_t e  = skip_space (line, pe);
@@ -66,14 +629,20 @@ static int do_include (struct cupl_fons *o, struct blob *line, size_t s)
 		return 0;
 	}
 
+	if (o->in.depth >= CUPL_INCLUDE_MAX) {
+		o->error = "Include nesting too deep";
+		return 0;
+	}
+
 	p[pe] = '\0';
 
-	return fons_push (&o->in, p + ps);
+	return fons_include (&o->in, p + ps);
 }
 
-static int do_define (struct cupl_fons *o, struct blob *line, size_t s)
+static int do_define (struct cupl_fons *o, size_t s)
 {
-	char *p = line->data;
+	const struct fons_line *line = &o->view;
+	char *p = o->cmd.data;
 	const size_t ns = skip_space (line, s);
 	const size_t ne = skip_word  (line, ns);	/* name start	*/
 	const size_t vs = skip_space (line, ne);
@@ -96,35 +665,449 @@ static int do_define (struct cupl_fons *o, struct blob *line, size_t s)
 	return patset_add (&o->vars, p + ns, p + vs);
 }
 
-struct blob *cupl_fons_read (struct cupl_fons *o)
+/*
+ * Cuts the single name argument of undef, ifdef and ifndef
+ */
+static const char *get_name (struct cupl_fons *o, size_t s)
 {
-	struct blob *line;
-	size_t s;
+	const struct fons_line *line = &o->view;
+	char *p = o->cmd.data;
+	const size_t ns = skip_space (line, s);
+	const size_t ne = skip_word  (line, ns);
+	const size_t e  = skip_space (line, ne);
+
+	if (ne == ns) {
+		o->error = "The directive requires a name argument";
+		return NULL;
+	}
+
+	if (p[e] != '\0') {
+		o->error = "Too many arguments for directive";
+		return NULL;
+	}
+
+	p[ne] = '\0';
+	return p + ns;
+}
+
+static int do_undef (struct cupl_fons *o, size_t s)
+{
+	const char *name;
+
+	if ((name = get_name (o, s)) == NULL)
+		return 0;
+
+	patset_del (&o->vars, name);
+	return 1;
+}
+
+static int do_ifdef (struct cupl_fons *o, size_t s, int defined)
+{
+	const char *name;
+
+	if ((name = get_name (o, s)) == NULL)
+		return 0;
+
+	if ((patset_find (&o->vars, name) != NULL) != defined)
+		o->skip = o->level + 1;
+
+	++o->level;
+	return 1;
+}
+
+static int do_else (struct cupl_fons *o)
+{
+	if (o->level == 0) {
+		o->error = "The else directive without ifdef";
+		return 0;
+	}
+
+	if (o->skip == o->level)
+		o->skip = 0;
+	else if (o->skip == 0)
+		o->skip = o->level;
+
+	return 1;
+}
+
+static int do_endif (struct cupl_fons *o)
+{
+	if (o->level == 0) {
+		o->error = "The endif directive without ifdef";
+		return 0;
+	}
+
+	if (o->skip == o->level)
+		o->skip = 0;
+
+	--o->level;
+	return 1;
+}
+
+/*
+ * $repeat index = [a, b..c, ...] and the body up to $repend
+ */
+static int get_ranges (struct cupl_fons *o, struct cupl_gen *g, size_t i)
+{
+	const struct fons_line *line = &o->view;
+	char *p = o->cmd.data, *end;
+	struct cupl_range r;
+
+	do {
+		r.from = r.to = strtol (p + ++i, &end, 10);
+
+		if (end == p + i)
+			goto error;
+
+		i = skip_space (line, end - p);
+
+		if (p[i] == '.' && p[i + 1] == '.') {
+			r.to = strtol (p + (i += 2), &end, 10);
+
+			if (end == p + i)
+				goto error;
+
+			i = skip_space (line, end - p);
+		}
+
+		if (!blob_write (&g->range, &r, sizeof (r)))
+			return 0;
+	}
+	while (p[i] == ',');
+
+	if (p[i] == ']' && p[skip_space (line, i + 1)] == '\0')
+		return 1;
+error:
+	o->error = "Invalid index list of repeat directive";
+	return 0;
+}
+
+static int do_repeat (struct cupl_fons *o, size_t s)
+{
+	const struct fons_line *line = &o->view;
+	char *p = o->cmd.data;
+	const size_t ns = skip_space (line, s);
+	const size_t ne = skip_word  (line, ns);	/* index name	*/
+	size_t i = skip_space (line, ne);
+	struct cupl_gen *g;
+
+	if (ne == ns || p[i] != '=' || p[i = skip_space (line, i + 1)] != '[') {
+		o->error = "The repeat directive requires index and list";
+		return 0;
+	}
+
+	if ((g = gen_alloc ()) == NULL)
+		return 0;
+
+	if (!get_ranges (o, g, i))
+		goto error;
+
+	p[ne] = '\0';
+
+	if ((g->index = strdup (p + ns)) == NULL ||
+	    !record (o, &g->body, DIR_REPEAT, DIR_REPEND))
+		goto error;
+
+	g->value = ((const struct cupl_range *) g->range.data)->from;
+	gen_push (o, g, g->body.data, g->body.count);
+	return 1;
+error:
+	gen_free (g);
+	return 0;
+}
+
+/*
+ * $macro name arg ... and the body up to $mend
+ */
+static int do_macro (struct cupl_fons *o, size_t s)
+{
+	const struct fons_line *line = &o->view;
+	const char *p = o->cmd.data;
+	size_t i = skip_space (line, s), e;
+	struct cupl_macro *m;
+
+	if ((m = calloc (1, sizeof (*m))) == NULL)
+		return 0;
+
+	blob_init (&m->args);
+	blob_init (&m->body);
+
+	for (; p[i] != '\0' && p[i] != ';'; i = skip_space (line, e), ++m->argc) {
+		if ((e = skip_word (line, i)) == i) {
+			o->error = "Invalid argument of macro directive";
+			goto error;
+		}
+
+		if (!blob_write (&m->args, p + i, e - i) ||
+		    !blob_write (&m->args, "", 1))
+			goto error;
+	}
+
+	if (m->argc == 0) {
+		o->error = "The macro directive requires a name argument";
+		goto error;
+	}
+
+	--m->argc;			/* the first one is the name	*/
+
+	if (!record (o, &m->body, DIR_MACRO, DIR_MEND))
+		goto error;
+
+	m->next  = o->macro;
+	o->macro = m;
+	return 1;
+error:
+	macro_free (m);
+	return 0;
+}
+
+static struct cupl_macro *
+find_macro (struct cupl_fons *o, const char *name, size_t len)
+{
+	struct cupl_macro *m;
+
+	for (m = o->macro; m != NULL; m = m->next)
+		if (strncmp (m->args.data, name, len) == 0 &&
+		    ((const char *) m->args.data)[len] == '\0')
+			return m;
+
+	return NULL;
+}
+
+/*
+ * name (arg, ...); binds arguments to the body of the macro
+ */
+static int do_call (struct cupl_fons *o, struct cupl_macro *m)
+{
+	const struct fons_line *line = &o->view;
+	const char *name = m->args.data;
+	char *p = o->cmd.data, end;
+	size_t i = skip_space (line, skip_word (line, skip_space (line, 0)));
+	size_t n = 0, depth = 0, as, ae;
+	struct cupl_gen *g;
+
+	if ((g = gen_alloc ()) == NULL)
+		return 0;
+
+	for (as = ++i;; ++i) {
+		if (p[i] == '\0') {
+			o->error = "Unterminated macro call";
+			goto error;
+		}
+
+		if (p[i] == '(')
+			++depth;
+		else if (p[i] == ')' && depth > 0)
+			--depth;
+		else if (depth == 0 && (p[i] == ',' || p[i] == ')')) {
+			end = p[i];
+			as = skip_space (line, as);
+
+			for (ae = i; ae > as && isspace ((unsigned char) p[ae - 1]); --ae) {}
+
+			if (end == ')' && n == 0 && ae == as)
+				break;
+
+			if (n++ == m->argc) {
+				o->error = "Too many arguments for macro call";
+				goto error;
+			}
+
+			name += strlen (name) + 1;
+			p[ae] = '\0';
+
+			if (!patset_add (&g->args, name, p + as))
+				goto error;
+
+			if (end == ')')
+				break;
+
+			as = i + 1;
+		}
+	}
+
+	if (n != m->argc) {
+		o->error = "Too few arguments for macro call";
+		goto error;
+	}
+
+	if (o->depth >= CUPL_GEN_MAX) {
+		o->error = "Macro nesting too deep";
+		goto error;
+	}
+
+	if (p[i = skip_space (line, i + 1)] == ';')
+		i = skip_space (line, i + 1);
+
+	if (p[i] != '\0') {
+		o->error = "Unexpected text after macro call";
+		goto error;
+	}
+
+	gen_push (o, g, m->body.data, m->body.count);
+	return 1;
+error:
+	gen_free (g);
+	return 0;
+}
+
+/*
+ * Replaces identifiers that name defines with define values, other text
+ * goes through untouched
+ */
+static int expand (struct cupl_fons *o, const struct fons_line *line)
+{
+	const char *s = line->data;
+	const struct pattern *p;
+	size_t i, e, at;
+
+	spans_reset (&o->out);
+
+	for (i = 0, at = 0; i < line->count; i = e) {
+		if (!isword ((unsigned char) s[i])) {
+			e = i + 1;
+			continue;
+		}
+
+		e = skip_word (line, i);
+
+		if ((p = patset_lookup (&o->vars, s + i, e - i)) == NULL)
+			continue;
+
+		if (!spans_add (&o->out, s + at, i - at) ||
+		    !spans_add (&o->out, p->value, p->vlen))
+			return 0;
+
+		at = e;
+	}
+
+	return spans_add (&o->out, s + at, line->count - at);
+}
+
+/*
+ * Copies the line into the directive buffer and terminates it with NUL
+ */
+static int copy_line (struct cupl_fons *o, const struct fons_line *line)
+{
+	blob_reset (&o->cmd);
+
+	if (!blob_write (&o->cmd, line->data, line->count) ||
+	    !blob_write (&o->cmd, "", 1))
+		return 0;
+
+	o->view.data  = o->cmd.data;
+	o->view.count = line->count;
+	return 1;
+}
+
+static int do_directive (struct cupl_fons *o, enum cupl_dir d, size_t s)
+{
+	switch (d) {
+	case DIR_DEFINE:	return do_define  (o, s);
+	case DIR_UNDEF:		return do_undef   (o, s);
+	case DIR_INCLUDE:	return do_include (o, s);
+	case DIR_IFDEF:		return do_ifdef   (o, s, 1);
+	case DIR_IFNDEF:	return do_ifdef   (o, s, 0);
+	case DIR_ELSE:		return do_else    (o);
+	case DIR_ENDIF:		return do_endif   (o);
+	case DIR_REPEAT:	return do_repeat  (o, s);
+	case DIR_MACRO:		return do_macro   (o, s);
+	case DIR_REPEND:
+		o->error = "The repend directive without repeat";
+		return 0;
+	case DIR_MEND:
+		o->error = "The mend directive without macro";
+		return 0;
+	default:
+		o->error = "Unknown preprocessor directive";
+		return 0;
+	}
+}
+
+/*
+ * Lines of skipped blocks are not parsed: only conditionals are tracked
+ */
+static int skip_directive (struct cupl_fons *o, enum cupl_dir d)
+{
+	switch (d) {
+	case DIR_IFDEF:
+	case DIR_IFNDEF:	++o->level;		return 1;
+	case DIR_ELSE:		return do_else  (o);
+	case DIR_ENDIF:		return do_endif (o);
+	default:		return 1;
+	}
+}
+
+/*
+ * Returns the macro if the line is a call of it
+ */
+static struct cupl_macro *
+is_call (struct cupl_fons *o, const struct fons_line *line)
+{
+	const size_t ns = skip_space (line, 0);
+	const size_t ne = skip_word  (line, ns);
+	const size_t i  = skip_space (line, ne);
+	struct cupl_macro *m;
+
+	if (ne == ns || i >= line->count || line->data[i] != '(' ||
+	    (m = find_macro (o, line->data + ns, ne - ns)) == NULL)
+		return NULL;
+
+	return m;
+}
+
+const struct fons_line *cupl_fons_read (struct cupl_fons *o)
+{
+	const struct fons_line *line;
+	struct cupl_macro *m;
+	enum cupl_dir d;
+	size_t e;
 loop:
-	if ((line = fons_read (&o->in)) == NULL)
+	if ((line = next_line (o)) == NULL) {
+		if (errno == 0 && o->level > 0)
+			o->error = "Unterminated conditional directive";
+
 		return NULL;
+	}
+
+	d = directive (line, skip_space (line, 0), &e);
+
+	if (o->skip > 0) {
+		if (!skip_directive (o, d))
+			return NULL;
 
-	s = skip_space (line, 0);
+		goto loop;
+	}
 
-	if (match_keyword (line, s, "$include")) {
-		if (!do_include (o, line, s + 8))
+	if (d != DIR_TEXT) {
+		if (!copy_line (o, line) || !do_directive (o, d, e))
 			return NULL;
 
 		goto loop;
 	}
 
-	if (match_keyword (line, s, "$define")) {
-		if (!do_define (o, line, s + 7))
+	if (o->macro != NULL && (m = is_call (o, line)) != NULL) {
+		if (!copy_line (o, line) || !do_call (o, m))
 			return NULL;
 
 		goto loop;
 	}
 
-//		o->error = "Unknown preprocessor directive";
-//		return NULL;
+	if (o->vars.count == 0)
+		return line;
+
+	if (!expand (o, line))
+		return NULL;
+
+	if (spans_is (&o->out, line->data, line->count))
+		return line;			/* nothing expanded	*/
+
+	blob_reset (&o->line);
 
-	if (!blob_write (&o->line, line->data, line->count))
+	if (!spans_gather (&o->out, &o->line))
 		return NULL;
 
-	return &o->line;
+	o->view.data  = o->line.data;
+	o->view.count = o->line.count;
+	return &o->view;
 }
@@ -14,11 +14,24 @@
 #include "blob.h"
 #include "fons.h"
 #include "patset.h"
+#include "spans.h"
+
+struct cupl_gen;
+struct cupl_macro;
 
 struct cupl_fons {
 	struct fons in;
 	struct patset vars;
-	struct blob line;
+	struct spans out;	/* line with expanded defines		*/
+	struct blob line, cmd;	/* line copies: substituted, directive	*/
+	struct fons_line view;	/* view of a line copy			*/
+
+	struct cupl_gen *gen;	/* replayed bodies, innermost first	*/
+	size_t depth;		/* number of active generators		*/
+	struct cupl_macro *macro; /* defined macros, latest first	*/
+	struct blob bound;	/* replayed line with bound arguments	*/
+	struct fons_line text;	/* view of a replayed line		*/
+	size_t level, skip;	/* conditional depth, skipped level or 0 */
 
 	const char *error;
 };
@@ -26,6 +39,16 @@ struct cupl_fons {
 int  cupl_fons_init (struct cupl_fons *o, const char *path);
 void cupl_fons_fini (struct cupl_fons *o);
 
-struct blob *cupl_fons_read (struct cupl_fons *o);
+/*
+ * cupl_fons_read returns a view of the next preprocessed line, valid until
+ * the next call. Identifiers that name defines are replaced with define
+ * values. Lines with no defines refer to the source file data directly.
+ *
+ * Directives $include, $define, $undef, $ifdef, $ifndef, $else, $endif,
+ * $repeat/$repend and $macro/$mend are handled in the stream. Bodies of
+ * repeats and macros are recorded once and replayed line by line with
+ * arguments in braces ({i}, {i+1}, {bits*2}) and macro arguments bound.
+ */
+const struct fons_line *cupl_fons_read (struct cupl_fons *o);
 
 #endif  /* CUPL_FONS_H */
@@ -0,0 +1,300 @@
+/*
+ * CUPL Batch Preprocessor Tool
+ *
+ * Copyright (c) 2025 Alexei A. Smekalkine <ikle@ikle.ru>
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <getopt.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "cupl-fons.h"
+#include "fcache.h"
+#include "fmap.h"
+#include "pool.h"
+
+struct job {
+	const char *path;
+	struct blob out;	/* preprocessed text			*/
+	struct blob deps;	/* make rule for the output file	*/
+	int done;		/* set by worker under lock		*/
+	const char *error;	/* error message or NULL		*/
+	int code;		/* errno value				*/
+};
+
+struct pp {
+	size_t count;
+	struct job *job;
+	const char *suffix;	/* output file suffix, stdout if NULL	*/
+	int deps;		/* write dependency files flag		*/
+	mode_t mode;		/* mode of output files			*/
+
+	pthread_mutex_t lock;
+	pthread_cond_t  cond;
+};
+
+/*
+ * Makes the rule for the output file, see fons_rule
+ */
+static int make_deps (struct job *o, const struct fons *in, const char *suffix)
+{
+	const size_t len = strlen (o->path);
+	char *target;
+	int ok;
+
+	if ((target = malloc (len + strlen (suffix) + 1)) == NULL)
+		return 0;
+
+	memcpy (target, o->path, len);
+	strcpy (target + len, suffix);
+
+	ok = fons_rule (in, target, &o->deps);
+	free (target);
+	return ok;
+}
+
+static int preprocess (struct pp *pp, struct job *o)
+{
+	struct cupl_fons in;
+	const struct fons_line *line;
+	int ok;
+
+	if (!cupl_fons_init (&in, o->path))
+		return 0;
+
+	while ((line = cupl_fons_read (&in)) != NULL)
+		if (!blob_write (&o->out, line->data, line->count))
+			break;
+
+	if ((ok = line == NULL && errno == 0 && in.error == NULL) == 0)
+		o->error = in.error;
+	else if (pp->deps)
+		ok = make_deps (o, &in.in, pp->suffix);
+
+	cupl_fons_fini (&in);
+	return ok;
+}
+
+static int worker (void *cookie, unsigned id, size_t i)
+{
+	struct pp *o = cookie;
+	struct job *job = o->job + i;
+	int ok;
+
+	if ((ok = preprocess (o, job)) == 0)
+		job->code = errno;
+
+	pthread_mutex_lock (&o->lock);
+	job->done = 1;
+	pthread_cond_broadcast (&o->cond);
+	pthread_mutex_unlock (&o->lock);
+	return ok;
+}
+
+static int same_file (const char *name, const struct blob *data)
+{
+	struct fmap f;
+	int same;
+
+	if (!fmap_open (&f, name))
+		return 0;
+
+	same = f.size == data->count &&
+	       (f.size == 0 || memcmp (f.data, data->data, f.size) == 0);
+
+	fmap_close (&f);
+	return same;
+}
+
+/*
+ * Writes data into the file path + suffix + ext, the file is left intact
+ * if it has the same contents already to keep its modification time.
+ * Data goes into a temporary file in the same directory first, then it
+ * is renamed into place: an interrupted write never leaves a truncated
+ * file that looks up to date.
+ */
+static int write_file (const char *path, const char *suffix, const char *ext,
+		       const struct blob *data, mode_t mode)
+{
+	const size_t len = strlen (path), slen = strlen (suffix);
+	const size_t elen = strlen (ext);
+	char *name, *temp;
+	int fd, ok;
+	FILE *f;
+
+	if ((name = malloc ((len + slen + elen) * 2 + 9)) == NULL)
+		return 0;
+
+	memcpy (name, path, len);
+	memcpy (name + len, suffix, slen);
+	strcpy (name + len + slen, ext);
+
+	if (same_file (name, data)) {
+		free (name);
+		return 1;
+	}
+
+	temp = name + len + slen + elen + 1;
+	strcpy (temp, name);
+	strcat (temp, ".XXXXXX");
+
+	if ((fd = mkstemp (temp)) < 0)
+		goto no_temp;
+
+	if (fchmod (fd, mode) != 0 || (f = fdopen (fd, "wb")) == NULL)
+		goto no_file;
+
+	ok = fwrite (data->data, 1, data->count, f) == data->count;
+
+	if (fclose (f) != 0 || !ok || rename (temp, name) != 0)
+		goto no_write;
+
+	free (name);
+	return 1;
+no_file:
+	ok = errno;
+	close (fd);
+	errno = ok;
+no_write:
+	ok = errno;
+	remove (temp);
+	errno = ok;
+no_temp:
+	free (name);
+	return 0;
+}
+
+/*
+ * Output thread: writes results in the input order as soon as they are
+ * ready, while workers go on with the next files
+ */
+static void *writer (void *cookie)
+{
+	struct pp *o = cookie;
+	struct job *job;
+	size_t i;
+	int ok = 1;
+
+	for (i = 0; i < o->count; ++i) {
+		job = o->job + i;
+
+		pthread_mutex_lock (&o->lock);
+
+		while (!job->done)
+			pthread_cond_wait (&o->cond, &o->lock);
+
+		pthread_mutex_unlock (&o->lock);
+
+		if (job->error != NULL || job->code != 0) {
+			fprintf (stderr, "E: %s: %s\n", job->path,
+				 job->error != NULL ? job->error :
+						      strerror (job->code));
+			ok = 0;
+		}
+		else if (o->suffix != NULL ?
+			 !write_file (job->path, o->suffix, "", &job->out,
+				     o->mode) :
+			 fwrite (job->out.data, 1, job->out.count, stdout) !=
+			 job->out.count) {
+			fprintf (stderr, "E: %s: cannot write output: %s\n",
+				 job->path, strerror (errno));
+			ok = 0;
+		}
+		else if (o->deps &&
+			 !write_file (job->path, o->suffix, ".d", &job->deps,
+				     o->mode)) {
+			fprintf (stderr, "E: %s: cannot write dependencies: %s\n",
+				 job->path, strerror (errno));
+			ok = 0;
+		}
+
+		blob_fini (&job->deps);
+		blob_init (&job->deps);
+		blob_fini (&job->out);
+		blob_init (&job->out);
+	}
+
+	if (fflush (stdout) != 0)
+		ok = 0;
+
+	return ok ? cookie : NULL;
+}
+
+static int usage (void)
+{
+	fprintf (stderr, "usage:\n"
+			 "\tcupl-pp [-t <threads>] [-s <suffix> [-d]] <pld-file> ...\n"
+			 "\n"
+			 "\t-t  number of worker threads, all CPUs by default\n"
+			 "\t-s  write output of every file into the file with\n"
+			 "\t    the suffix appended to its name, otherwise\n"
+			 "\t    write all outputs to stdout in order\n"
+			 "\t-d  write make rule for every output file into the\n"
+			 "\t    file with .d appended to the output file name\n"
+			 "\n"
+			 "Output files are left intact if not changed.\n");
+	return 1;
+}
+
+int main (int argc, char *argv[])
+{
+	unsigned threads = 0;
+	struct pp o = { 0 };
+	pthread_t out;
+	void *status;
+	size_t i;
+	int opt, ok;
+
+	while ((opt = getopt (argc, argv, "t:s:d")) != -1)
+		switch (opt) {
+		case 't':	threads  = atoi (optarg);	break;
+		case 's':	o.suffix = optarg;		break;
+		case 'd':	o.deps   = 1;			break;
+		default:	return usage ();
+		}
+
+	if (optind >= argc || (o.deps && o.suffix == NULL))
+		return usage ();
+
+	o.count = argc - optind;
+	o.mode  = umask (0);
+	umask (o.mode);
+	o.mode  = 0666 & ~o.mode;
+
+	if ((o.job = calloc (o.count, sizeof (o.job[0]))) == NULL) {
+		perror ("E");
+		return 1;
+	}
+
+	for (i = 0; i < o.count; ++i) {
+		o.job[i].path = argv[optind + i];
+		blob_init (&o.job[i].out);
+		blob_init (&o.job[i].deps);
+	}
+
+	pthread_mutex_init (&o.lock, NULL);
+	pthread_cond_init  (&o.cond, NULL);
+
+	if ((errno = pthread_create (&out, NULL, writer, &o)) != 0) {
+		perror ("E");
+		return 1;
+	}
+
+	ok = pool_run (o.count, threads, worker, &o);
+	ok = pthread_join (out, &status) == 0 && status != NULL && ok;
+
+	fcache_clear ();
+
+	pthread_cond_destroy  (&o.cond);
+	pthread_mutex_destroy (&o.lock);
+	free (o.job);
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,186 @@
+/*
+ * Shared File Cache
+ *
+ * Copyright (c) 2025 Alexei A. Smekalkine <ikle@ikle.ru>
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <stddef.h>
+#include <stdlib.h>
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "fcache.h"
+
+#define FCACHE_BUCKETS	256
+
+struct fcache_file {
+	struct fcache_file *next;	/* bucket chain			*/
+	size_t refs;			/* users plus one if cached	*/
+
+	dev_t dev;			/* file identity		*/
+	ino_t ino;
+	off_t size;			/* file version			*/
+	struct timespec mtime;
+
+	struct fmap file;
+};
+
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static struct fcache_file *bucket[FCACHE_BUCKETS];
+
+static size_t fcache_hash (dev_t dev, ino_t ino)
+{
+	const unsigned long long x = (unsigned long long) dev * 0x9e3779b97f4a7c15 ^ ino;
+
+	return (x ^ x >> 29) % FCACHE_BUCKETS;
+}
+
+static int fcache_valid (const struct fcache_file *o, const struct stat *st)
+{
+	return o->size == st->st_size &&
+	       o->mtime.tv_sec  == st->st_mtim.tv_sec &&
+	       o->mtime.tv_nsec == st->st_mtim.tv_nsec;
+}
+
+static void fcache_unref (struct fcache_file *o)
+{
+	if (--o->refs > 0)
+		return;
+
+	fmap_close (&o->file);
+	free (o);
+}
+
+/*
+ * Looks the file up, drops the outdated version from the cache. Called
+ * with the lock held.
+ */
+static struct fcache_file *fcache_find (const struct stat *st)
+{
+	struct fcache_file **p, *o;
+
+	for (p = bucket + fcache_hash (st->st_dev, st->st_ino); (o = *p) != NULL;
+	     p = &o->next) {
+		if (o->dev != st->st_dev || o->ino != st->st_ino)
+			continue;
+
+		if (fcache_valid (o, st))
+			return o;
+
+		*p = o->next;
+		fcache_unref (o);
+		break;
+	}
+
+	return NULL;
+}
+
+static struct fcache_file *fcache_load (int fd, const struct stat *st)
+{
+	struct fcache_file *o;
+
+	if ((o = malloc (sizeof (*o))) == NULL)
+		return NULL;
+
+	if (!fmap_open_fd (&o->file, fd, st)) {
+		free (o);
+		return NULL;
+	}
+
+	o->refs  = 1;
+	o->dev   = st->st_dev;
+	o->ino   = st->st_ino;
+	o->size  = st->st_size;
+	o->mtime = st->st_mtim;
+	return o;
+}
+
+/*
+ * The file is opened once: the cache key comes from the status of the
+ * descriptor that is mapped, thus a file replaced meanwhile cannot get
+ * into the cache under the key of the old one
+ */
+const struct fmap *fcache_open (const char *path)
+{
+	struct stat st;
+	struct fcache_file *o, *other;
+	size_t i;
+	int fd;
+
+	if ((fd = open (path, O_RDONLY)) == -1)
+		return NULL;
+
+	if (fstat (fd, &st) != 0)
+		goto no_stat;
+
+	pthread_mutex_lock (&lock);
+
+	if ((o = fcache_find (&st)) != NULL) {
+		++o->refs;
+		pthread_mutex_unlock (&lock);
+		close (fd);
+		return &o->file;
+	}
+
+	pthread_mutex_unlock (&lock);
+
+	o = fcache_load (fd, &st);			/* load unlocked */
+	close (fd);
+
+	if (o == NULL)
+		return NULL;
+
+	pthread_mutex_lock (&lock);
+
+	if ((other = fcache_find (&st)) != NULL) {	/* lost the race */
+		++other->refs;
+		pthread_mutex_unlock (&lock);
+		fcache_unref (o);
+		return &other->file;
+	}
+
+	i = fcache_hash (st.st_dev, st.st_ino);
+	o->next   = bucket[i];
+	bucket[i] = o;
+	++o->refs;
+
+	pthread_mutex_unlock (&lock);
+	return &o->file;
+no_stat:
+	close (fd);
+	return NULL;
+}
+
+void fcache_close (const struct fmap *file)
+{
+	struct fcache_file *o = (void *) ((const char *) file -
+					  offsetof (struct fcache_file, file));
+
+	pthread_mutex_lock (&lock);
+	fcache_unref (o);
+	pthread_mutex_unlock (&lock);
+}
+
+void fcache_clear (void)
+{
+	struct fcache_file **p, *o;
+	size_t i;
+
+	pthread_mutex_lock (&lock);
+
+	for (i = 0; i < FCACHE_BUCKETS; ++i)
+		for (p = bucket + i; (o = *p) != NULL;)
+			if (o->refs == 1) {
+				*p = o->next;
+				fcache_unref (o);
+			}
+			else
+				p = &o->next;
+
+	pthread_mutex_unlock (&lock);
+}
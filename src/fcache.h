@@ -0,0 +1,29 @@
+/*
+ * Shared File Cache
+ *
+ * Copyright (c) 2025 Alexei A. Smekalkine <ikle@ikle.ru>
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#ifndef FCACHE_H
+#define FCACHE_H  1
+
+#include "fmap.h"
+
+/*
+ * fcache_open returns the contents of the specified file from the
+ * process-wide cache, or maps the file and adds it to the cache. A cached
+ * file is identified by device and inode numbers and is valid while its
+ * size and modification time stay the same, thus a cache hit costs an
+ * open and a stat call. Safe to call from several threads.
+ *
+ * fcache_close releases the file returned by fcache_open.
+ *
+ * fcache_clear drops all the files not in use from the cache.
+ */
+const struct fmap *fcache_open (const char *path);
+void fcache_close (const struct fmap *file);
+void fcache_clear (void);
+
+#endif  /* FCACHE_H */
@@ -0,0 +1,97 @@
+/*
+ * Read-only File Mapping
+ *
+ * Copyright (c) 2025 Alexei A. Smekalkine <ikle@ikle.ru>
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <errno.h>
+#include <stdlib.h>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "fmap.h"
+
+static int fmap_read (struct fmap *o, int fd)
+{
+	size_t size = 0, next;
+	char *data = NULL, *p;
+	ssize_t len;
+
+	for (o->size = 0;; o->size += len) {
+		if (o->size == size) {
+			next = size == 0 ? 4096 : size * 2;
+
+			if (next < size) {	/* size overflow */
+				errno = ENOMEM;
+				goto error;
+			}
+
+			if ((p = realloc (data, next)) == NULL)
+				goto error;
+
+			data = p;
+			size = next;
+		}
+
+		if ((len = read (fd, data + o->size, size - o->size)) == 0)
+			break;
+
+		if (len < 0) {
+			if (errno != EINTR)
+				goto error;
+
+			len = 0;
+		}
+	}
+
+	o->data   = data;
+	o->mapped = 0;
+	return 1;
+error:
+	free (data);
+	return 0;
+}
+
+int fmap_open_fd (struct fmap *o, int fd, const struct stat *st)
+{
+	if (!S_ISREG (st->st_mode) || st->st_size == 0)
+		return fmap_read (o, fd);
+
+	o->data = mmap (NULL, st->st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+	if (o->data == MAP_FAILED)
+		return fmap_read (o, fd);
+
+	(void) madvise (o->data, st->st_size, MADV_SEQUENTIAL);
+
+	o->size   = st->st_size;
+	o->mapped = 1;
+	return 1;
+}
+
+int fmap_open (struct fmap *o, const char *path)
+{
+	int fd, ok;
+	struct stat st;
+
+	if ((fd = open (path, O_RDONLY)) == -1)
+		return 0;
+
+	ok = fstat (fd, &st) == 0 && fmap_open_fd (o, fd, &st);
+
+	close (fd);
+	return ok;
+}
+
+void fmap_close (struct fmap *o)
+{
+	if (o->mapped)
+		munmap (o->data, o->size);
+	else
+		free (o->data);
+}
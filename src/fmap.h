@@ -0,0 +1,36 @@
+/*
+ * Read-only File Mapping
+ *
+ * Copyright (c) 2025 Alexei A. Smekalkine <ikle@ikle.ru>
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#ifndef FMAP_H
+#define FMAP_H  1
+
+#include <stddef.h>
+
+struct fmap {
+	void *data;		/* file contents			*/
+	size_t size;		/* file size				*/
+	int mapped;		/* data mapped, allocated otherwise	*/
+};
+
+/*
+ * fmap_open maps the specified file into memory read-only. If the file
+ * cannot be mapped (pipes, character devices, etc.) then reads the whole
+ * file into an allocated buffer.
+ *
+ * fmap_open_fd does the same for the open file descriptor fd with status
+ * st, the descriptor is left open.
+ *
+ * fmap_close unmaps (or frees) the file data.
+ */
+struct stat;
+
+int  fmap_open    (struct fmap *o, const char *path);
+int  fmap_open_fd (struct fmap *o, int fd, const struct stat *st);
+void fmap_close   (struct fmap *o);
+
+#endif  /* FMAP_H */
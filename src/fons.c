@@ -7,42 +7,63 @@
  */
 
 #include <stdlib.h>
+#include <string.h>
 
+#include "fcache.h"
 #include "fons.h"
 
 int fons_init (struct fons *o, const char *path)
 {
 	o->input = NULL;
+	o->line.data  = NULL;
+	o->line.count = 0;
+	o->depth = 0;
 
-	if (!fons_push (o, path))
-		return 0;
+	blob_init (&o->deps);
+	o->hash = 0xcbf29ce484222325;
 
-	blob_init (&o->line);
-	return 1;
+	if (fons_push (o, path))
+		return 1;
+
+	fons_fini (o);
+	return 0;
 }
 
 void fons_fini (struct fons *o)
 {
-	blob_fini (&o->line);
-
 	while (o->input != NULL)
 		fons_pop (o);
+
+	blob_fini (&o->deps);
 }
 
-struct blob *fons_read (struct fons *o)
+const struct fons_line *fons_next (struct fons *o)
 {
-	struct fons_input *in;
-	struct blob *line = &o->line;
-	ssize_t n;
+	struct fons_input *in = o->input;
+	const char *s, *e;
+	size_t avail;
 
-	while ((in = o->input) != NULL) {
-		if ((n = getline (&line->data, &line->size, in->file)) != -1) {
-			line->count = n;
-			return line;
-		}
+	if (in == NULL || (avail = in->file->size - in->pos) == 0) {
+		errno = 0;
+		return NULL;
+	}
+
+	s = (const char *) in->file->data + in->pos;
+	e = memchr (s, '\n', avail);
+
+	o->line.data  = s;
+	o->line.count = e == NULL ? avail : e - s + 1;
+	in->pos += o->line.count;
+	return &o->line;
+}
+
+const struct fons_line *fons_read (struct fons *o)
+{
+	const struct fons_line *line;
 
-		if (!feof (in->file))
-			return NULL;  /* report error */
+	while (o->input != NULL) {
+		if ((line = fons_next (o)) != NULL)
+			return line;
 
 		fons_pop (o);
 	}
@@ -51,31 +72,128 @@ struct blob *fons_read (struct fons *o)
 	return NULL;  /* report EOF */
 }
 
-int fons_push (struct fons *o, const char *path)
+static uint64_t fons_hash (uint64_t h, const void *data, size_t size)
+{
+	const unsigned char *p = data;
+	size_t i;
+
+	for (i = 0; i < size; ++i)
+		h = (h ^ p[i]) * 0x100000001b3;
+
+	return h;
+}
+
+/*
+ * Records the path of the file opened and mixes its contents into the
+ * stream hash on the first opening only
+ */
+static int fons_record (struct fons *o, const char *path,
+			const struct fmap *file)
+{
+	const char *p = o->deps.data, *end = p + o->deps.count;
+	const uint64_t size = file->size;
+
+	for (; p < end; p += strlen (p) + 1)
+		if (strcmp (p, path) == 0)
+			return 1;
+
+	o->hash = fons_hash (o->hash, file->data, file->size);
+	o->hash = fons_hash (o->hash, &size, sizeof (size));
+
+	return blob_write (&o->deps, path, strlen (path) + 1);
+}
+
+static int fons_open (struct fons *o, const char *path, int shared)
 {
 	struct fons_input *in;
 
 	if ((in = malloc (sizeof (*in))) == NULL)
 		return 0;
 
-	if ((in->file = fopen (path, "rb")) == NULL)
+	if (shared)
+		in->file = fcache_open (path);
+	else
+		in->file = fmap_open (&in->own, path) ? &in->own : NULL;
+
+	if (in->file == NULL)
 		goto no_open;
 
+	in->pos  = 0;
 	in->next = o->input;
 	o->input = in;
-	return 1;
+	++o->depth;
+
+	return fons_record (o, path, in->file);
 no_open:
 	free (in);
 	return 0;
 }
 
+int fons_push (struct fons *o, const char *path)
+{
+	return fons_open (o, path, 0);
+}
+
+int fons_include (struct fons *o, const char *path)
+{
+	return fons_open (o, path, 1);
+}
+
 void fons_pop (struct fons *o)
 {
 	struct fons_input *in = o->input;
 
 	if (in != NULL) {
 		o->input = in->next;
-		fclose (in->file);
+		--o->depth;
+
+		if (in->file == &in->own)
+			fmap_close (&in->own);
+		else
+			fcache_close (in->file);
+
 		free (in);
 	}
 }
+
+/*
+ * Appends the file name escaped for make
+ */
+static int rule_name (struct blob *o, const char *name)
+{
+	for (; *name != '\0'; ++name) {
+		if ((*name == ' ' || *name == '#') && !blob_write (o, "\\", 1))
+			return 0;
+
+		if (*name == '$' && !blob_write (o, "$", 1))
+			return 0;
+
+		if (!blob_write (o, name, 1))
+			return 0;
+	}
+
+	return 1;
+}
+
+int fons_rule (const struct fons *o, const char *target, struct blob *out)
+{
+	const char *p = o->deps.data, *end = p + o->deps.count, *q;
+
+	if (!blob_printf (out, "# hash %016llx\n", (unsigned long long) o->hash) ||
+	    !rule_name (out, target) || !blob_write (out, ":", 1))
+		return 0;
+
+	for (q = p; q < end; q += strlen (q) + 1)
+		if (!blob_write (out, " ", 1) || !rule_name (out, q))
+			return 0;
+
+	if (!blob_write (out, "\n", 1))
+		return 0;
+
+	for (q = p + strlen (p) + 1; q < end; q += strlen (q) + 1)
+		if (!blob_write (out, "\n", 1) || !rule_name (out, q) ||
+		    !blob_write (out, ":\n", 2))
+			return 0;
+
+	return 1;
+}
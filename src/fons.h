@@ -10,18 +10,41 @@
 #define FONS_H  1
 
 #include <errno.h>
-#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
 
 #include "blob.h"
+#include "fmap.h"
 
 struct fons_input {
 	struct fons_input *next;
-	FILE *file;
+	const struct fmap *file;	/* own or shared file data	*/
+	struct fmap own;
+	size_t pos;			/* offset of the next line	*/
 };
 
+/*
+ * Line view: points to the file data directly, thus it is read-only, is
+ * not NUL-terminated and includes the line end character if any
+ */
+struct fons_line {
+	const char *data;
+	size_t count;
+};
+
+/*
+ * Every file opened by the stream is recorded for dependency tracking:
+ * deps holds NUL-terminated paths of the files in the order of the first
+ * opening, each path once, and hash is the 64-bit FNV-1a hash of their
+ * contents.
+ */
 struct fons {
 	struct fons_input *input;
-	struct blob line;
+	struct fons_line line;
+	size_t depth;		/* number of files on the source stack	*/
+
+	struct blob deps;	/* paths of all opened files		*/
+	uint64_t hash;		/* hash of contents of opened files	*/
 };
 
 /*
@@ -35,23 +58,41 @@ int  fons_init (struct fons *o, const char *path);
 void fons_fini (struct fons *o);
 
 /*
- * fons_read attempts to read a line from the file on the top of the stream
- * source stack. Returns NULL if there is an error reading from the file.
- * If the end of file is reached, then closes the file on the top of the
- * stack and removes it from the top of the stack (see fons_pop), then
- * tries to read the line again. If the stack is empty, sets errno to zero
- * and returns NULL.
+ * fons_read returns a view of the next line of the file on the top of the
+ * stream source stack. If the end of file is reached, then closes the file
+ * on the top of the stack and removes it from the top of the stack (see
+ * fons_pop), then tries to read the line again. If the stack is empty,
+ * sets errno to zero and returns NULL. The view is valid until the next
+ * call to fons_read or fons_pop.
+ *
+ * fons_next does the same but reads from the file on the top of the stack
+ * only: at the end of it sets errno to zero and returns NULL, and the
+ * file stays on the stack.
  */
-struct blob *fons_read (struct fons *o);
+const struct fons_line *fons_read (struct fons *o);
+const struct fons_line *fons_next (struct fons *o);
 
 /*
- * fons_push opens the specified file and pushes it onto the top of the
+ * fons_push maps the specified file into memory (or reads it whole if it
+ * cannot be mapped, see fmap_open) and pushes it onto the top of the
  * stream source stack.
  *
+ * fons_include does the same, but takes the file from the process-wide
+ * file cache (see fcache_open): for files included many times.
+ *
  * fons_pop closes the file on the top of the stream source stack and
  * removes it from the stack.
  */
-int  fons_push (struct fons *o, const char *path);
-void fons_pop  (struct fons *o);
+int  fons_push    (struct fons *o, const char *path);
+int  fons_include (struct fons *o, const char *path);
+void fons_pop     (struct fons *o);
+
+/*
+ * fons_rule appends to out the make rule for target: it depends on all the
+ * files opened by the stream, the included ones get empty rules to not
+ * break the build when they are removed. The stream hash goes into the
+ * comment line before the rule. File names are escaped for make.
+ */
+int fons_rule (const struct fons *o, const char *target, struct blob *out);
 
 #endif  /* FONS_H */
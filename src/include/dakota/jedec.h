@@ -10,6 +10,7 @@
 #define DAKOTA_JEDEC_H  1
 
 #include <stddef.h>
+#include <stdint.h>
 
 struct jedec *jedec_alloc (const char *device);
 void jedec_free (struct jedec *o);
@@ -20,11 +21,180 @@ int    jedec_get_default (struct jedec *o);
 size_t jedec_get_count   (struct jedec *o);
 void  *jedec_get_fuses   (struct jedec *o);
 
+/*
+ * jedec_get_checksum returns the JEDEC fuse checksum: the 16-bit sum of
+ * all fuses packed into 8-bit words, the first fuse of a word in its least
+ * significant bit.
+ */
+unsigned jedec_get_checksum (struct jedec *o);
+
 int jedec_set_count   (struct jedec *o, size_t count);
 int jedec_set_default (struct jedec *o, int def);
 int jedec_set_device  (struct jedec *o, const char *device);
 
+/*
+ * jedec_get_bits returns width (up to 64) fuses starting at the specified
+ * address packed into a word, the fuse at the address in its least
+ * significant bit. jedec_set_bits stores width fuses from the value.
+ *
+ * jedec_get_range and jedec_set_range transfer count fuses starting at the
+ * specified address to or from an array of such words, 64 fuses per word,
+ * the last word is padded with zeros.
+ *
+ * jedec_copy_range copies count fuses from the source fuse map starting at
+ * address from into the fuse map starting at address to, the ranges may
+ * overlap.
+ *
+ * All these functions fail and set errno to EFAULT if a range does not fit
+ * into a fuse map (jedec_get_bits returns zero in this case).
+ */
+uint64_t jedec_get_bits (struct jedec *o, size_t addr, unsigned width);
+int jedec_set_bits (struct jedec *o, size_t addr, unsigned width,
+		    uint64_t value);
+
+int jedec_get_range (struct jedec *o, size_t addr, size_t count, uint64_t *to);
+int jedec_set_range (struct jedec *o, size_t addr, size_t count,
+		     const uint64_t *from);
+
+int jedec_copy_range (struct jedec *o, size_t to, struct jedec *src,
+		      size_t from, size_t count);
+
+/*
+ * jedec_diff compares fuse maps of the same size 64 fuses at a time and
+ * calls fn (if not NULL) for every fuse that differs in ascending address
+ * order, passing it the fuse address and the fuse values in both maps.
+ * Fuses set in the optional mask map are don't-care and never reported.
+ * Returns the number of differing fuses, or (size_t) -1 if the maps (or
+ * mask) have different sizes (errno is set to EINVAL) or fn returns zero
+ * (errno is left as fn sets it, or set to ECANCELED if fn does not).
+ */
+typedef int jedec_diff_fn (void *cookie, size_t addr, int a, int b);
+
+size_t jedec_diff (struct jedec *a, struct jedec *b, struct jedec *mask,
+		   jedec_diff_fn *fn, void *cookie);
+
+/*
+ * NOTE index record: the NOTE kind with its numbers and the fuse range of
+ * the L field it describes:
+ *
+ *   JEDEC_NOTE_PT      "PT index of MC block"
+ *   JEDEC_NOTE_MUX     "Mux-index of block X", block = X - 'A'
+ *   JEDEC_NOTE_SWITCH  "Sindex, Saux of block X", block = X - 'A'
+ *
+ * jedec_get_notes returns the number of index records and stores a
+ * pointer to the records ordered by (kind, block, index, aux) into notes.
+ *
+ * jedec_find_note returns the first record with the specified kind, block
+ * and index, or NULL if there is no such record.
+ */
+enum jedec_note_kind {
+	JEDEC_NOTE_PT = 1,
+	JEDEC_NOTE_MUX,
+	JEDEC_NOTE_SWITCH,
+};
+
+struct jedec_note {
+	int kind;
+	unsigned block, index, aux;
+	size_t addr, count;
+};
+
+size_t jedec_get_notes (struct jedec *o, const struct jedec_note **notes);
+
+const struct jedec_note *
+jedec_find_note (struct jedec *o, int kind, unsigned block, unsigned index);
+
+/*
+ * jedec_load_mem parses JEDEC file image of the specified size in a single
+ * pass without copying it. Returns NULL and sets errno to EILSEQ if the
+ * image is malformed.
+ *
+ * If the JEDEC_STRICT flag is set, then the fuse checksum and the
+ * transmission checksum are verified (if present and non-zero), and NULL
+ * is returned with errno set to EBADMSG on mismatch.
+ *
+ * If the JEDEC_NOTES flag is set, then NOTE fields following L fields are
+ * recorded into the NOTE index of the fuse map (see jedec_find_note).
+ *
+ * jedec_load_ex maps the specified file into memory and parses it with
+ * jedec_load_mem, jedec_load does the same without any flags.
+ *
+ * jedec_save writes the fuse map with valid fuse and transmission
+ * checksums.
+ */
+#define JEDEC_STRICT	1
+#define JEDEC_NOTES	2
+
+struct jedec *jedec_load_mem (const void *data, size_t size, int flags);
+struct jedec *jedec_load_ex  (const char *path, int flags);
 struct jedec *jedec_load (const char *path);
 int jedec_save (struct jedec *o, const char *path);
 
+/*
+ * jedec_load_many loads the specified files into a corpus of fuse maps in
+ * parallel using the specified number of threads (zero selects the number
+ * of online CPUs). Fuse arrays of all maps are stored in a single block in
+ * the order of paths. Returns NULL on memory allocation failure only.
+ *
+ * jedec_corpus_get returns the fuse map for the file with the specified
+ * index, or NULL if the file failed to load (errno is set to the reason).
+ * The maps are owned by the corpus and must not be freed by the caller.
+ */
+struct jedec_corpus *
+jedec_load_many (const char *const paths[], size_t count, unsigned threads);
+void jedec_corpus_free (struct jedec_corpus *o);
+
+size_t jedec_corpus_count (struct jedec_corpus *o);
+struct jedec *jedec_corpus_get (struct jedec_corpus *o, size_t i);
+
+/*
+ * jedec_save_bin writes the specified fuse maps into a binary fuse map
+ * cache file: a versioned index of maps (device name, default, fuse count)
+ * followed by 64-bit aligned fuse arrays.
+ *
+ * jedec_open_bin maps the binary fuse map cache file into memory and
+ * returns a corpus of its maps, fuse arrays are used in place without
+ * copying. Fuse maps of such corpus are read-only. Returns NULL and sets
+ * errno to EILSEQ if the file is malformed.
+ */
+int jedec_save_bin (struct jedec *const maps[], size_t count, const char *path);
+struct jedec_corpus *jedec_open_bin (const char *path);
+
+/*
+ * Snapshot store keeps a copy of the base fuse map in full and every
+ * snapshot as a sorted list of addresses of fuses that differ from base.
+ *
+ * jedec_store_alloc creates a store with a copy of the specified base map,
+ * jedec_store_get_base returns that copy.
+ *
+ * jedec_store_add records the difference of the sample map from the base
+ * map as a new snapshot and returns its index, or (size_t) -1 on error.
+ *
+ * jedec_store_get_delta returns the number of fuses changed by snapshot
+ * and stores a pointer to their sorted addresses into addr.
+ *
+ * jedec_store_apply toggles the fuses changed by snapshot in the fuse map
+ * of the base size: it turns the base map into the snapshot and vice
+ * versa in O(delta). jedec_store_get materializes snapshot as a new fuse
+ * map.
+ *
+ * jedec_store_diff compares two snapshots in O(delta) in the same way as
+ * jedec_diff compares fuse maps.
+ */
+struct jedec_store *jedec_store_alloc (struct jedec *base);
+void jedec_store_free (struct jedec_store *o);
+
+struct jedec *jedec_store_get_base (struct jedec_store *o);
+size_t jedec_store_count (struct jedec_store *o);
+
+size_t jedec_store_add (struct jedec_store *o, struct jedec *sample);
+size_t jedec_store_get_delta (struct jedec_store *o, size_t i,
+			      const uint32_t **addr);
+
+int jedec_store_apply (struct jedec_store *o, size_t i, struct jedec *to);
+struct jedec *jedec_store_get (struct jedec_store *o, size_t i);
+
+size_t jedec_store_diff (struct jedec_store *o, size_t i, size_t j,
+			 jedec_diff_fn *fn, void *cookie);
+
 #endif  /* DAKOTA_JEDEC_H */
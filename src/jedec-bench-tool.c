@@ -0,0 +1,309 @@
+/*
+ * Dakota JEDEC Throughput Benchmark
+ *
+ * Copyright (c) 2025 Alexei A. Smekalkine <ikle@ikle.ru>
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <getopt.h>
+
+#include <dakota/jedec.h>
+
+#include "allocs.h"
+
+static const struct device {
+	const char *name;
+	size_t count;
+} devices[] = {
+	{ "ATF1502AS", 16808 },
+	{ "ATF1504AS", 34192 },
+	{ "ATF1508AS", 74919 },
+};
+
+static const char *patterns[] = { "zeros", "ones", "random", "sparse" };
+
+static const char *layouts[] = { "dense", "atmel", "single" };
+
+#define ARRAY_SIZE(a)	(sizeof (a) / sizeof ((a)[0]))
+
+static int fuse (const char *pattern)
+{
+	switch (pattern[0]) {
+	case 'o':	return 1;
+	case 'r':	return rand () & 1;
+	case 's':	return rand () % 100 == 0;
+	}
+
+	return 0;
+}
+
+/*
+ * Generate JEDEC text of the specified fuse map with the specified layout
+ * of L fields:
+ *
+ *   dense   64 fuses per L field, the layout of jedec_save;
+ *   atmel   96-fuse L fields split into 16/40/40 lines with CRLF line
+ *           ends and a NOTE per field, the layout of the Atmel fitter;
+ *   single  all fuses in one L field, 80 fuses per line.
+ */
+static char *make_text (struct jedec *o, const char *layout, size_t *size)
+{
+	const size_t count = jedec_get_count (o);
+	size_t i, step, line;
+	char *text;
+	FILE *f;
+
+	if ((f = open_memstream (&text, size)) == NULL)
+		return NULL;
+
+	fprintf (f, "\002JEDEC file for: %s\r\n*QF%zu*\r\nF0*\r\n",
+		 jedec_get_device (o), count);
+
+	step = layout[0] == 'd' ? 64 : layout[0] == 'a' ? 96 : count;
+	line = layout[0] == 'a' ? 16 : layout[0] == 's' ? 80 : 64;
+
+	for (i = 0; i < count; ++i) {
+		if (i % step == 0)
+			fprintf (f, "L%05zu ", i);
+
+		fputc (jedec_get_bits (o, i, 1) ? '1' : '0', f);
+
+		if ((i + 1) % step == 0 || i + 1 == count) {
+			if (layout[0] == 'a')
+				fprintf (f, "*  NOTE PT %zu of MC %zu *\r\n",
+					 i / step % 5 + 1, i / step / 5 + 1);
+			else
+				fprintf (f, "*\r\n");
+		}
+		else if (layout[0] == 'a' && (i % step == 15 ||
+					      i % step == 55))
+			fprintf (f, "\r\n");
+		else if (layout[0] == 's' && (i + 1) % line == 0)
+			fprintf (f, "\r\n");
+	}
+
+	fprintf (f, "C%04X*\r\n\0030000\r\n", jedec_get_checksum (o));
+
+	if (fclose (f) != 0)
+		return NULL;
+
+	return text;
+}
+
+static struct jedec *make_map (const struct device *d, const char *pattern)
+{
+	struct jedec *o;
+	size_t i;
+
+	if ((o = jedec_alloc (d->name)) == NULL ||
+	    !jedec_set_count (o, d->count) || !jedec_set_default (o, 0))
+		goto error;
+
+	for (i = 0; i < d->count; ++i)
+		jedec_set_bits (o, i, 1, fuse (pattern));
+
+	return o;
+error:
+	jedec_free (o);
+	return NULL;
+}
+
+/*
+ * Benchmark runner
+ */
+struct bench {
+	const struct device *dev;
+	const char *pattern, *layout;
+
+	const char *text;
+	size_t size;
+
+	struct jedec *a, *b;
+};
+
+static uint64_t now (void)
+{
+	struct timespec ts;
+
+	clock_gettime (CLOCK_MONOTONIC, &ts);
+	return (uint64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static int op_load (struct bench *o)
+{
+	struct jedec *m;
+
+	if ((m = jedec_load_mem (o->text, o->size, 0)) == NULL)
+		return 0;
+
+	jedec_free (m);
+	return 1;
+}
+
+static int op_save (struct bench *o)
+{
+	return jedec_save (o->a, "/dev/null");
+}
+
+static volatile size_t sink;	/* keeps results of pure operations */
+
+static int op_checksum (struct bench *o)
+{
+	sink = jedec_get_checksum (o->a);
+	return 1;
+}
+
+static int op_diff (struct bench *o)
+{
+	const size_t n = jedec_diff (o->a, o->b, NULL, NULL, NULL);
+
+	sink = n;
+	return n != (size_t) -1;
+}
+
+static const struct op {
+	const char *name;
+	int (*fn) (struct bench *o);
+	int text;		/* throughput in text bytes, fuse bytes otherwise */
+	int layout;		/* depends on layout of L fields	*/
+} ops[] = {
+	{ "load",	op_load,	1, 1 },
+	{ "save",	op_save,	1, 0 },
+	{ "checksum",	op_checksum,	0, 0 },
+	{ "diff",	op_diff,	0, 0 },
+};
+
+static int u64_cmp (const void *a, const void *b)
+{
+	const uint64_t *l = a, *r = b;
+
+	return *l < *r ? -1 : *l > *r;
+}
+
+static int run (struct bench *o, const struct op *op, size_t warmup,
+		size_t iters, uint64_t *t)
+{
+	const size_t bytes = op->text ? o->size : (o->dev->count + 7) / 8;
+	size_t i, count;
+	uint64_t start;
+
+	for (i = 0; i < warmup; ++i)
+		if (!op->fn (o))
+			return 0;
+
+	count = allocs;
+
+	for (i = 0; i < iters; ++i) {
+		start = now ();
+
+		if (!op->fn (o))
+			return 0;
+
+		t[i] = now () - start;
+	}
+
+	count = allocs - count;
+	qsort (t, iters, sizeof (t[0]), u64_cmp);
+
+	printf ("%s,%s,%zu,%s,%s,%zu,%zu,%llu,%llu,%llu,%llu,%.1f,%.2f\n",
+		op->name, o->dev->name, o->dev->count, o->pattern, o->layout,
+		iters, bytes,
+		(unsigned long long) t[0],
+		(unsigned long long) t[iters / 2],
+		(unsigned long long) t[iters * 90 / 100],
+		(unsigned long long) t[iters * 99 / 100],
+		bytes * 1e3 / (t[iters / 2] > 0 ? t[iters / 2] : 1),
+		(double) count / iters);
+	return 1;
+}
+
+static int bench (struct bench *o, size_t warmup, size_t iters, uint64_t *t)
+{
+	size_t i, addr;
+	int ok = 1;
+
+	o->a = o->b = NULL;
+
+	if ((o->a = make_map (o->dev, o->pattern)) == NULL ||
+	    (o->b = make_map (o->dev, o->pattern)) == NULL)
+		goto error;
+
+	for (i = 0; i < 16; ++i) {		/* a few sample changes	*/
+		addr = (size_t) rand () % o->dev->count;
+		jedec_set_bits (o->b, addr, 1, !jedec_get_bits (o->a, addr, 1));
+	}
+
+	if ((o->text = make_text (o->a, o->layout, &o->size)) == NULL)
+		goto error;
+
+	for (i = 0; i < ARRAY_SIZE (ops); ++i)
+		if ((ops[i].layout || o->layout == layouts[0]) &&
+		    !run (o, ops + i, warmup, iters, t)) {
+			fprintf (stderr, "E: %s: %s, %s, %s failed\n",
+				 ops[i].name, o->dev->name, o->pattern,
+				 o->layout);
+			ok = 0;
+		}
+
+	free ((void *) o->text);
+	jedec_free (o->b);
+	jedec_free (o->a);
+	return ok;
+error:
+	perror ("E");
+	jedec_free (o->b);
+	jedec_free (o->a);
+	return 0;
+}
+
+static int usage (void)
+{
+	fprintf (stderr, "usage:\n"
+			 "\tjedec-bench [-w <warmup>] [-n <iterations>]\n"
+			 "\n"
+			 "Prints CSV: times in nanoseconds, throughput in MB/s,\n"
+			 "allocations per operation.\n");
+	return 1;
+}
+
+int main (int argc, char *argv[])
+{
+	size_t warmup = 20, iters = 200, d, p, l;
+	struct bench o = { NULL };
+	uint64_t *t;
+	int opt, ok = 1;
+
+	while ((opt = getopt (argc, argv, "w:n:")) != -1)
+		switch (opt) {
+		case 'w':	warmup = strtoul (optarg, NULL, 0);	break;
+		case 'n':	iters  = strtoul (optarg, NULL, 0);	break;
+		default:	return usage ();
+		}
+
+	if (iters == 0 || (t = malloc (iters * sizeof (t[0]))) == NULL)
+		return usage ();
+
+	srand (1);
+
+	printf ("op,device,fuses,pattern,layout,iters,bytes,"
+		"min_ns,median_ns,p90_ns,p99_ns,mb_per_s,allocs_per_op\n");
+
+	for (d = 0; d < ARRAY_SIZE (devices); ++d)
+		for (p = 0; p < ARRAY_SIZE (patterns); ++p)
+			for (l = 0; l < ARRAY_SIZE (layouts); ++l) {
+				o.dev     = devices + d;
+				o.pattern = patterns[p];
+				o.layout  = layouts[l];
+
+				ok &= bench (&o, warmup, iters, t);
+			}
+
+	free (t);
+	return ok ? 0 : 1;
+}
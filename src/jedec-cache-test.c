@@ -0,0 +1,106 @@
+/*
+ * Dakota Binary Fuse Map Cache Test
+ *
+ * Copyright (c) 2025 Alexei A. Smekalkine <ikle@ikle.ru>
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <dakota/jedec.h>
+
+#define CACHE	"jedec-cache-test.jfc"
+#define TEXT_A	"jedec-cache-test-a.jed"
+#define TEXT_B	"jedec-cache-test-b.jed"
+
+static struct jedec *make_map (size_t count, int def, unsigned seed)
+{
+	struct jedec *o;
+	size_t i;
+
+	if ((o = jedec_alloc ("ATF1502AS")) == NULL ||
+	    !jedec_set_count (o, count) || !jedec_set_default (o, def))
+		goto error;
+
+	srand (seed);
+
+	for (i = 0; i < count; i += 1 + rand () % 61)
+		jedec_set_bits (o, i, count - i < 3 ? count - i : 3, rand ());
+
+	return o;
+error:
+	jedec_free (o);
+	return NULL;
+}
+
+static int same_file (const char *a, const char *b)
+{
+	FILE *fa = fopen (a, "rb"), *fb = fopen (b, "rb");
+	int ca, cb, same = fa != NULL && fb != NULL;
+
+	while (same) {
+		ca = fgetc (fa);
+		cb = fgetc (fb);
+
+		if ((same = ca == cb) && ca == EOF)
+			break;
+	}
+
+	if (fa != NULL)  fclose (fa);
+	if (fb != NULL)  fclose (fb);
+	return same;
+}
+
+/*
+ * Saves text form of generated maps, saves maps into binary cache, then
+ * saves text form of cached maps and compares both text forms.
+ */
+int main (int argc, char *argv[])
+{
+	static const size_t count[] = { 0, 1, 63, 64, 65, 16808, 34192, 74919 };
+	const size_t n = sizeof (count) / sizeof (count[0]);
+	struct jedec *maps[2 * n];
+	struct jedec_corpus *c;
+	size_t i;
+	int ok = 1;
+
+	for (i = 0; i < 2 * n; ++i)
+		if ((maps[i] = make_map (count[i % n], i / n, i)) == NULL) {
+			perror ("E: make map");
+			return 1;
+		}
+
+	if (!jedec_save_bin (maps, 2 * n, CACHE) ||
+	    (c = jedec_open_bin (CACHE)) == NULL) {
+		perror ("E: " CACHE);
+		return 1;
+	}
+
+	if (jedec_corpus_count (c) != 2 * n) {
+		fprintf (stderr, "E: map count mismatch\n");
+		ok = 0;
+	}
+
+	for (i = 0; ok && i < 2 * n; ++i)
+		if (!jedec_save (maps[i], TEXT_A) ||
+		    !jedec_save (jedec_corpus_get (c, i), TEXT_B) ||
+		    !same_file (TEXT_A, TEXT_B)) {
+			fprintf (stderr, "E: map %zu differs\n", i);
+			ok = 0;
+		}
+
+	printf ("I: %zu maps round trip %s\n", 2 * n, ok ? "ok" : "failed");
+
+	jedec_corpus_free (c);
+
+	for (i = 0; i < 2 * n; ++i)
+		jedec_free (maps[i]);
+
+	remove (CACHE);
+	remove (TEXT_A);
+	remove (TEXT_B);
+	return ok ? 0 : 1;
+}
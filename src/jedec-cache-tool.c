@@ -0,0 +1,121 @@
+/*
+ * Dakota Binary Fuse Map Cache Tool
+ *
+ * Copyright (c) 2025 Alexei A. Smekalkine <ikle@ikle.ru>
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <dakota/jedec.h>
+
+static int usage (void)
+{
+	fprintf (stderr, "usage:\n"
+			 "\tjedec-cache -o <cache-file> <jedec-file> ...\n"
+			 "\tjedec-cache -l <cache-file>\n"
+			 "\tjedec-cache -x <cache-file> <index> <jedec-file>\n");
+	return 1;
+}
+
+static int do_build (const char *path, char *argv[], size_t count)
+{
+	struct jedec_corpus *c;
+	struct jedec **maps;
+	size_t i, n;
+	int ok = 0;
+
+	if ((c = jedec_load_many ((const char *const *) argv, count, 0)) == NULL)
+		goto no_load;
+
+	if ((maps = malloc ((count + 1) * sizeof (maps[0]))) == NULL)
+		goto no_maps;
+
+	for (i = 0, n = 0; i < count; ++i)
+		if ((maps[n] = jedec_corpus_get (c, i)) != NULL)
+			++n;
+		else
+			fprintf (stderr, "E: %s: %s\n", argv[i], strerror (errno));
+
+	if (!(ok = jedec_save_bin (maps, n, path)))
+		perror (path);
+
+	free (maps);
+	jedec_corpus_free (c);
+	return ok;
+no_maps:
+	jedec_corpus_free (c);
+no_load:
+	perror ("E");
+	return 0;
+}
+
+static int do_list (const char *path)
+{
+	struct jedec_corpus *c;
+	struct jedec *o;
+	const char *device;
+	size_t i;
+
+	if ((c = jedec_open_bin (path)) == NULL) {
+		perror (path);
+		return 0;
+	}
+
+	printf ("index,device,count,checksum\n");
+
+	for (i = 0; i < jedec_corpus_count (c); ++i) {
+		o = jedec_corpus_get (c, i);
+		device = jedec_get_device (o);
+
+		printf ("%zu,%s,%zu,%04X\n", i, device == NULL ? "" : device,
+			jedec_get_count (o), jedec_get_checksum (o));
+	}
+
+	jedec_corpus_free (c);
+	return 1;
+}
+
+static int do_extract (const char *path, const char *index, const char *out)
+{
+	struct jedec_corpus *c;
+	struct jedec *o;
+	int ok;
+
+	if ((c = jedec_open_bin (path)) == NULL) {
+		perror (path);
+		return 0;
+	}
+
+	if ((o = jedec_corpus_get (c, strtoul (index, NULL, 0))) == NULL) {
+		fprintf (stderr, "E: %s: No map with index %s\n", path, index);
+		jedec_corpus_free (c);
+		return 0;
+	}
+
+	if (!(ok = jedec_save (o, out)))
+		perror (out);
+
+	jedec_corpus_free (c);
+	return ok;
+}
+
+int main (int argc, char *argv[])
+{
+	int ok;
+
+	if (argc > 3 && strcmp (argv[1], "-o") == 0)
+		ok = do_build (argv[2], argv + 3, argc - 3);
+	else if (argc == 3 && strcmp (argv[1], "-l") == 0)
+		ok = do_list (argv[2]);
+	else if (argc == 5 && strcmp (argv[1], "-x") == 0)
+		ok = do_extract (argv[2], argv[3], argv[4]);
+	else
+		return usage ();
+
+	return ok ? 0 : 1;
+}
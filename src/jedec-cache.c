@@ -0,0 +1,213 @@
+/*
+ * Dakota Binary Fuse Map Cache
+ *
+ * Copyright (c) 2025 Alexei A. Smekalkine <ikle@ikle.ru>
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "jedec-map.h"
+
+/*
+ * File layout, all numbers are little-endian:
+ *
+ *   head				file header
+ *   entry[count]			map descriptors
+ *   uint64_t fuses[]			fuse words of all maps
+ *
+ * Fuse words of every map start at 64-bit aligned offset, fuse i is bit
+ * i % 64 of word i / 64.
+ */
+#define JFC_MAGIC	"DJFC"
+#define JFC_VERSION	1
+
+struct jfc_head {
+	char magic[4];
+	uint32_t version;
+	uint64_t count;		/* number of maps			*/
+	uint64_t size;		/* total file size			*/
+	uint64_t reserved;
+};
+
+struct jfc_entry {
+	char device[32];	/* NUL-terminated device name		*/
+	uint64_t count;		/* number of fuses			*/
+	uint64_t offset;	/* file offset of fuse words		*/
+	uint32_t def;		/* default fuse state			*/
+	uint32_t reserved;
+	uint64_t reserved2;
+};
+
+static inline uint64_t le64 (uint64_t x)
+{
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+	return __builtin_bswap64 (x);
+#else
+	return x;
+#endif
+}
+
+static inline uint32_t le32 (uint32_t x)
+{
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+	return __builtin_bswap32 (x);
+#else
+	return x;
+#endif
+}
+
+static int jfc_write (struct jedec *const maps[], size_t count, FILE *out)
+{
+	struct jfc_head  h = { JFC_MAGIC };
+	struct jfc_entry e;
+	uint64_t offset = sizeof (h) + count * sizeof (e);
+	size_t i, len;
+	int ok;
+
+	for (i = 0; i < count; ++i)
+		offset += jedec_words (maps[i]) * 8;
+
+	h.version = le32 (JFC_VERSION);
+	h.count   = le64 (count);
+	h.size    = le64 (offset);
+
+	ok = fwrite (&h, sizeof (h), 1, out) == 1;
+
+	offset = sizeof (h) + count * sizeof (e);
+
+	for (i = 0; i < count; ++i) {
+		memset (&e, 0, sizeof (e));
+		memcpy (e.device, maps[i]->device, strlen (maps[i]->device));
+
+		e.count  = le64 (maps[i]->count);
+		e.offset = le64 (offset);
+		e.def    = le32 (maps[i]->def);
+
+		ok &= fwrite (&e, sizeof (e), 1, out) == 1;
+		offset += jedec_words (maps[i]) * 8;
+	}
+
+	for (i = 0; i < count; ++i)
+		if ((len = jedec_words (maps[i]) * 8) > 0)
+			ok &= fwrite (maps[i]->fuses, len, 1, out) == 1;
+
+	return ok;
+}
+
+int jedec_save_bin (struct jedec *const maps[], size_t count, const char *path)
+{
+	FILE *out;
+	size_t i;
+
+	for (i = 0; i < count; ++i)
+		if (maps[i]->fuses == NULL && maps[i]->count > 0) {
+			errno = EINVAL;
+			return 0;
+		}
+
+	if ((out = fopen (path, "wb")) == NULL)
+		return 0;
+
+	if (!jfc_write (maps, count, out))
+		goto no_write;
+
+	return fclose (out) == 0;
+no_write:
+	fclose (out);
+	return 0;
+}
+
+static int jfc_map (struct jedec *o, const struct jfc_entry *e,
+		    const struct fmap *f)
+{
+	const uint64_t count  = le64 (e->count);
+	const uint64_t offset = le64 (e->offset);
+	const uint64_t words  = count / 64 + ((count & 63) != 0);
+	uint64_t tail;
+
+	if (e->device[sizeof (e->device) - 1] != '\0' || le32 (e->def) > 1 ||
+	    (offset & 7) != 0 || offset > f->size ||
+	    words > (f->size - offset) / 8)
+		return 0;
+
+	if ((count & 63) != 0) {	/* bits past count must be clear */
+		memcpy (&tail, (const char *) f->data + offset + (words - 1) * 8,
+			sizeof (tail));
+
+		if ((le64 (tail) >> (count & 63)) != 0)
+			return 0;
+	}
+
+	memcpy (o->device, e->device, sizeof (o->device));
+
+	o->def   = le32 (e->def);
+	o->count = count;
+	o->fuses = (char *) f->data + offset;
+	return 1;
+}
+
+static int jfc_read (struct jedec_corpus *o)
+{
+	const struct fmap *f = o->file;
+	const struct jfc_head *h = f->data;
+	const struct jfc_entry *e = (const void *) (h + 1);
+	size_t i, count;
+
+	if (f->size < sizeof (*h) || memcmp (h->magic, JFC_MAGIC, 4) != 0 ||
+	    le32 (h->version) != JFC_VERSION || le64 (h->size) != f->size ||
+	    (count = le64 (h->count)) > (f->size - sizeof (*h)) / sizeof (*e))
+		goto error;
+
+	o->count = count;
+
+	if ((o->map   = calloc (count + 1, sizeof (o->map[0])))   == NULL ||
+	    (o->error = calloc (count + 1, sizeof (o->error[0]))) == NULL)
+		return 0;
+
+	for (i = 0; i < count; ++i) {
+		jedec_init (o->map + i, "", &o->store);
+
+		if (!jfc_map (o->map + i, e + i, f))
+			goto error;
+	}
+
+	return 1;
+error:
+	errno = EILSEQ;
+	return 0;
+}
+
+struct jedec_corpus *jedec_open_bin (const char *path)
+{
+	struct jedec_corpus *o;
+	int error;
+
+	if ((o = calloc (1, sizeof (*o))) == NULL)
+		return NULL;
+
+	arena_init (&o->store);
+
+	if ((o->file = malloc (sizeof (*o->file))) == NULL)
+		goto error;
+
+	if (!fmap_open (o->file, path)) {
+		free (o->file);
+		o->file = NULL;
+		goto error;
+	}
+
+	if (!jfc_read (o))
+		goto error;
+
+	return o;
+error:
+	error = errno;
+	jedec_corpus_free (o);
+	errno = error;
+	return NULL;
+}
@@ -0,0 +1,160 @@
+/*
+ * Dakota JEDEC Fuse Map Corpus
+ *
+ * Copyright (c) 2025 Alexei A. Smekalkine <ikle@ikle.ru>
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "fmap.h"
+#include "jedec-map.h"
+#include "pool.h"
+
+struct loader {
+	const char *const *path;
+	struct jedec_corpus *corpus;
+	struct arena *arena;	/* per-worker fuse arenas		*/
+};
+
+static int load_one (void *cookie, unsigned worker, size_t i)
+{
+	struct loader *o = cookie;
+	struct jedec *map = o->corpus->map + i;
+	struct fmap m;
+	int ok;
+
+	jedec_init (map, "", o->arena + worker);
+
+	if (!fmap_open (&m, o->path[i]))
+		goto error;
+
+	ok = jedec_parse (map, m.data, m.size, 0);
+	fmap_close (&m);
+
+	if (ok) {
+		o->corpus->error[i] = 0;
+		return 1;
+	}
+error:
+	o->corpus->error[i] = errno != 0 ? errno : EIO;
+	map->count = 0;
+	map->fuses = NULL;
+	return 0;
+}
+
+/*
+ * Move fuse arrays of all maps from the worker arenas into a single block
+ * in the order of maps.
+ */
+static int jedec_corpus_pack (struct jedec_corpus *o)
+{
+	size_t i, total = 0, len;
+	char *p;
+
+	for (i = 0; i < o->count; ++i)
+		total += jedec_words (o->map + i) * 8;
+
+	if (total == 0)
+		return 1;
+
+	if ((p = arena_alloc (&o->store, total)) == NULL)
+		return 0;
+
+	for (i = 0; i < o->count; ++i) {
+		if ((len = jedec_words (o->map + i) * 8) > 0)
+			memcpy (p, o->map[i].fuses, len);
+
+		o->map[i].fuses = p;
+		o->map[i].arena = &o->store;
+		p += len;
+	}
+
+	return 1;
+}
+
+struct jedec_corpus *
+jedec_load_many (const char *const paths[], size_t count, unsigned threads)
+{
+	struct jedec_corpus *o;
+	struct loader l = { paths };
+	unsigned i;
+	size_t j;
+
+	if ((o = malloc (sizeof (*o))) == NULL)
+		return NULL;
+
+	o->count = count;
+	o->map   = calloc (count, sizeof (o->map[0]));
+	o->error = calloc (count, sizeof (o->error[0]));
+	o->file  = NULL;
+	arena_init (&o->store);
+
+	threads = pool_threads (threads);
+
+	if ((count > 0 && (o->map == NULL || o->error == NULL)) ||
+	    (l.arena = malloc (threads * sizeof (l.arena[0]))) == NULL)
+		goto no_mem;
+
+	l.corpus = o;
+
+	for (i = 0; i < threads; ++i)
+		arena_init (l.arena + i);
+
+	for (j = 0; j < count; ++j)	/* until loaded by load_one */
+		o->error[j] = ENOMEM;
+
+	/* failures are recorded per file, see jedec_corpus_get */
+	pool_run (count, threads, load_one, &l);
+
+	if (!jedec_corpus_pack (o))
+		goto no_pack;
+
+	for (i = 0; i < threads; ++i)
+		arena_fini (l.arena + i);
+
+	free (l.arena);
+	return o;
+no_pack:
+	for (i = 0; i < threads; ++i)
+		arena_fini (l.arena + i);
+
+	free (l.arena);
+no_mem:
+	jedec_corpus_free (o);
+	return NULL;
+}
+
+void jedec_corpus_free (struct jedec_corpus *o)
+{
+	if (o == NULL)
+		return;
+
+	if (o->file != NULL) {
+		fmap_close (o->file);
+		free (o->file);
+	}
+
+	arena_fini (&o->store);
+	free (o->error);
+	free (o->map);
+	free (o);
+}
+
+size_t jedec_corpus_count (struct jedec_corpus *o)
+{
+	return o->count;
+}
+
+struct jedec *jedec_corpus_get (struct jedec_corpus *o, size_t i)
+{
+	if (i >= o->count || o->error[i] != 0) {
+		errno = i >= o->count ? EINVAL : o->error[i];
+		return NULL;
+	}
+
+	return o->map + i;
+}
@@ -0,0 +1,171 @@
+/*
+ * Dakota JEDEC Fuse Map Difference Tool
+ *
+ * Copyright (c) 2025 Alexei A. Smekalkine <ikle@ikle.ru>
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <getopt.h>
+
+#include <dakota/jedec.h>
+
+struct ctx {
+	const char *path;
+	int json, first;
+};
+
+static int show_csv (void *cookie, size_t addr, int a, int b)
+{
+	struct ctx *o = cookie;
+
+	return printf ("%s,%zu,%d,%d\n", o->path, addr, a, b) > 0;
+}
+
+static int show_json (void *cookie, size_t addr, int a, int b)
+{
+	struct ctx *o = cookie;
+	const char *sep = o->first ? "" : ",";
+
+	o->first = 0;
+	return printf ("%s\n\t\t{\"addr\": %zu, \"a\": %d, \"b\": %d}",
+		       sep, addr, a, b) > 0;
+}
+
+static void show_string (const char *s)
+{
+	putchar ('"');
+
+	for (; *s != '\0'; ++s)
+		if (*s == '"' || *s == '\\')
+			printf ("\\%c", *s);
+		else if ((unsigned char) *s < 0x20)
+			printf ("\\u%04x", *s);
+		else
+			putchar (*s);
+
+	putchar ('"');
+}
+
+static int diff (struct jedec *a, struct jedec *mask, struct ctx *o)
+{
+	struct jedec *b;
+	size_t n;
+	int code;
+
+	if ((b = jedec_load (o->path)) == NULL) {
+		perror (o->path);
+		return 0;
+	}
+
+	if (jedec_get_count (b) != jedec_get_count (a)) {
+		fprintf (stderr, "%s: Fuse count mismatch\n", o->path);
+		jedec_free (b);
+		return 0;
+	}
+
+	if (o->json) {
+		printf ("%s\n\t{\"file\": ", o->first ? "" : ",");
+		show_string (o->path);
+		printf (", \"diff\": [");
+		o->first = 1;
+	}
+
+	n = jedec_diff (a, b, mask, o->json ? show_json : show_csv, o);
+	jedec_free (b);
+
+	if (n == -1) {
+		code = errno;
+		perror (o->path);
+
+		if (o->json) {				/* close the record */
+			printf ("\n\t], \"error\": ");
+			show_string (strerror (code));
+			putchar ('}');
+		}
+
+		o->first = 0;
+		return 0;
+	}
+
+	if (o->json)
+		printf ("%s], \"count\": %zu}", n > 0 ? "\n\t" : "", n);
+
+	o->first = 0;
+	return 1;
+}
+
+static struct jedec *load (const char *path)
+{
+	struct jedec *o;
+
+	if ((o = jedec_load (path)) == NULL)
+		perror (path);
+
+	return o;
+}
+
+static int usage (void)
+{
+	fprintf (stderr, "usage:\n"
+			 "\tjedec-diff [-j] [-m <mask-file>] "
+			 "<base-file> <jedec-file> ...\n"
+			 "\n"
+			 "\t-j  output JSON instead of CSV\n"
+			 "\t-m  do not report fuses set in the mask file\n");
+	return 1;
+}
+
+int main (int argc, char *argv[])
+{
+	struct ctx c = { NULL, 0, 1 };
+	const char *mpath = NULL;
+	struct jedec *a, *mask = NULL;
+	int opt, i, ok = 1;
+
+	while ((opt = getopt (argc, argv, "jm:")) != -1)
+		switch (opt) {
+		case 'j':	c.json = 1;	break;
+		case 'm':	mpath = optarg;	break;
+		default:	return usage ();
+		}
+
+	if (argc - optind < 2)
+		return usage ();
+
+	if ((a = load (argv[optind])) == NULL)
+		return 1;
+
+	if (mpath != NULL && (mask = load (mpath)) == NULL)
+		goto error;
+
+	if (mask != NULL && jedec_get_count (mask) != jedec_get_count (a)) {
+		fprintf (stderr, "%s: Fuse count mismatch\n", mpath);
+		goto error;
+	}
+
+	if (c.json)
+		printf ("[");
+	else
+		printf ("file,addr,a,b\n");
+
+	for (i = optind + 1; i < argc; ++i) {
+		c.path = argv[i];
+		ok &= diff (a, mask, &c);
+	}
+
+	if (c.json)
+		printf ("\n]\n");
+
+	jedec_free (mask);
+	jedec_free (a);
+	return ok ? 0 : 1;
+error:
+	jedec_free (mask);
+	jedec_free (a);
+	return 1;
+}
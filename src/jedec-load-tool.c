@@ -0,0 +1,72 @@
+/*
+ * Dakota JEDEC Batch Loader Tool
+ *
+ * Copyright (c) 2025 Alexei A. Smekalkine <ikle@ikle.ru>
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <getopt.h>
+
+#include <dakota/jedec.h>
+
+static int usage (void)
+{
+	fprintf (stderr, "usage:\n"
+			 "\tjedec-load [-t <threads>] <jedec-file> ...\n"
+			 "\n"
+			 "\t-t  number of worker threads, all CPUs by default\n");
+	return 1;
+}
+
+int main (int argc, char *argv[])
+{
+	unsigned threads = 0;
+	struct jedec_corpus *c;
+	struct jedec *o;
+	const char *device;
+	size_t i, count;
+	int opt, ok = 1;
+
+	while ((opt = getopt (argc, argv, "t:")) != -1)
+		switch (opt) {
+		case 't':	threads = atoi (optarg);	break;
+		default:	return usage ();
+		}
+
+	if (optind >= argc)
+		return usage ();
+
+	count = argc - optind;
+
+	if ((c = jedec_load_many ((const char *const *) argv + optind, count,
+				  threads)) == NULL) {
+		perror ("E");
+		return 1;
+	}
+
+	printf ("file,device,count,checksum\n");
+
+	for (i = 0; i < count; ++i) {
+		if ((o = jedec_corpus_get (c, i)) == NULL) {
+			fprintf (stderr, "E: %s: %s\n", argv[optind + i],
+				 strerror (errno));
+			ok = 0;
+			continue;
+		}
+
+		device = jedec_get_device (o);
+
+		printf ("%s,%s,%zu,%04X\n", argv[optind + i],
+			device == NULL ? "" : device, jedec_get_count (o),
+			jedec_get_checksum (o));
+	}
+
+	jedec_corpus_free (c);
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,84 @@
+/*
+ * Dakota JEDEC Fuse Map Internals
+ *
+ * Copyright (c) 2022-2025 Alexei A. Smekalkine <ikle@ikle.ru>
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#ifndef JEDEC_MAP_H
+#define JEDEC_MAP_H  1
+
+#include <stdint.h>
+#include <string.h>
+
+#include <dakota/jedec.h>
+
+#include "arena.h"
+#include "fmap.h"
+
+struct jedec {
+	char device[32];
+
+	int def;
+	size_t count;
+	void *fuses;		/* fuse array in whole 64-bit words	*/
+	struct arena *arena;	/* owner of fuses, heap if NULL		*/
+
+	size_t notes, nsize;	/* NOTE index size and available space	*/
+	struct jedec_note *note;
+};
+
+struct jedec_corpus {
+	size_t count;
+	struct jedec *map;	/* fuse maps in the order of paths	*/
+	int *error;		/* load errors (errno values)		*/
+	struct arena store;	/* contiguous fuse arrays of all maps	*/
+	struct fmap *file;	/* mapped fuse cache file, if any	*/
+};
+
+/*
+ * jedec_init initializes a fuse map object in place, the fuse array will
+ * be allocated from the specified arena (or from heap if arena is NULL).
+ *
+ * jedec_parse parses JEDEC file image into the initialized fuse map, see
+ * jedec_load_mem. Returns zero and sets errno on error, the fuse map
+ * object should be finalized by the caller anyway.
+ */
+void jedec_init  (struct jedec *o, const char *device, struct arena *arena);
+int  jedec_parse (struct jedec *o, const void *data, size_t size, int flags);
+
+/*
+ * jedec_note_add appends a record to the NOTE index of the fuse map,
+ * jedec_note_sort orders the index for lookups, jedec_note_fini releases
+ * the index.
+ */
+int  jedec_note_add  (struct jedec *o, const struct jedec_note *note);
+void jedec_note_sort (struct jedec *o);
+void jedec_note_fini (struct jedec *o);
+
+static inline size_t jedec_words (const struct jedec *o)
+{
+	return o->count / 64 + ((o->count & 63) != 0);
+}
+
+static inline uint64_t load_word (const struct jedec *o, size_t i)
+{
+	uint64_t x;
+
+	memcpy (&x, (const char *) o->fuses + i * 8, sizeof (x));
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+	x = __builtin_bswap64 (x);
+#endif
+	return x;
+}
+
+static inline void store_word (struct jedec *o, size_t i, uint64_t x)
+{
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+	x = __builtin_bswap64 (x);
+#endif
+	memcpy ((char *) o->fuses + i * 8, &x, sizeof (x));
+}
+
+#endif  /* JEDEC_MAP_H */
@@ -0,0 +1,106 @@
+/*
+ * Dakota JEDEC NOTE Index
+ *
+ * Copyright (c) 2025 Alexei A. Smekalkine <ikle@ikle.ru>
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <errno.h>
+#include <stdlib.h>
+
+#include "jedec-map.h"
+
+void jedec_note_fini (struct jedec *o)
+{
+	free (o->note);
+
+	o->notes = 0;
+	o->nsize = 0;
+	o->note  = NULL;
+}
+
+static int jedec_note_resize (struct jedec *o)
+{
+	struct jedec_note *p;
+	const size_t next = o->nsize == 0 ? 64 : o->nsize * 2;
+
+	if (next < o->nsize || next > (size_t) -1 / sizeof (p[0])) {
+		errno = ENOMEM;  /* size overflow */
+		return 0;
+	}
+
+	if ((p = realloc (o->note, next * sizeof (p[0]))) == NULL)
+		return 0;
+
+	o->note  = p;
+	o->nsize = next;
+	return 1;
+}
+
+int jedec_note_add (struct jedec *o, const struct jedec_note *note)
+{
+	if (o->notes >= o->nsize && !jedec_note_resize (o))
+		return 0;
+
+	o->note[o->notes++] = *note;
+	return 1;
+}
+
+static int key_cmp (int kind, unsigned block, unsigned index,
+		    const struct jedec_note *b)
+{
+	if (kind  != b->kind)   return kind  < b->kind  ? -1 : 1;
+	if (block != b->block)  return block < b->block ? -1 : 1;
+	if (index != b->index)  return index < b->index ? -1 : 1;
+
+	return 0;
+}
+
+static int note_cmp (const void *a, const void *b)
+{
+	const struct jedec_note *l = a, *r = b;
+	int ret;
+
+	if ((ret = key_cmp (l->kind, l->block, l->index, r)) != 0)
+		return ret;
+
+	if (l->aux != r->aux)
+		return l->aux < r->aux ? -1 : 1;
+
+	/* keep records with equal keys in file order */
+
+	return l->addr < r->addr ? -1 : l->addr > r->addr;
+}
+
+void jedec_note_sort (struct jedec *o)
+{
+	if (o->notes > 1)
+		qsort (o->note, o->notes, sizeof (o->note[0]), note_cmp);
+}
+
+size_t jedec_get_notes (struct jedec *o, const struct jedec_note **notes)
+{
+	*notes = o->note;
+	return o->notes;
+}
+
+const struct jedec_note *
+jedec_find_note (struct jedec *o, int kind, unsigned block, unsigned index)
+{
+	size_t lo = 0, hi = o->notes, mid;
+
+	while (lo < hi) {	/* find lower bound */
+		mid = lo + (hi - lo) / 2;
+
+		if (key_cmp (kind, block, index, o->note + mid) > 0)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	if (lo < o->notes && key_cmp (kind, block, index, o->note + lo) == 0)
+		return o->note + lo;
+
+	return NULL;
+}
@@ -0,0 +1,110 @@
+/*
+ * Dakota JEDEC NOTE Index Dump Tool
+ *
+ * Copyright (c) 2025 Alexei A. Smekalkine <ikle@ikle.ru>
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include <getopt.h>
+
+#include <dakota/jedec.h>
+
+static const char *kind_name[] = { "", "pt", "mux", "switch" };
+
+static int parse_kind (const char *name)
+{
+	int i;
+
+	for (i = 1; i < sizeof (kind_name) / sizeof (kind_name[0]); ++i)
+		if (strcmp (name, kind_name[i]) == 0)
+			return i;
+
+	return -1;
+}
+
+static void show_fuses (struct jedec *o, size_t addr, size_t count)
+{
+	uint64_t x;
+	unsigned i, n;
+
+	for (; count > 0; addr += n, count -= n) {
+		n = count < 64 ? count : 64;
+		x = jedec_get_bits (o, addr, n);
+
+		for (i = 0; i < n; ++i)
+			putchar ((x >> i & 1) != 0 ? '1' : '0');
+	}
+}
+
+static int dump (const char *path, int kind)
+{
+	struct jedec *o;
+	const struct jedec_note *p;
+	size_t i, count;
+
+	if ((o = jedec_load_ex (path, JEDEC_NOTES)) == NULL) {
+		perror (path);
+		return 0;
+	}
+
+	count = jedec_get_notes (o, &p);
+
+	for (i = 0; i < count; ++i, ++p) {
+		if (kind > 0 && p->kind != kind)
+			continue;
+
+		printf ("%s,%s,", path, kind_name[p->kind]);
+
+		if (p->kind == JEDEC_NOTE_PT)
+			printf ("%u,", p->block);
+		else
+			printf ("%c,", 'A' + p->block);
+
+		printf ("%u,%u,%zu,%zu,", p->index, p->aux, p->addr, p->count);
+		show_fuses (o, p->addr, p->count);
+		putchar ('\n');
+	}
+
+	jedec_free (o);
+	return 1;
+}
+
+static int usage (void)
+{
+	fprintf (stderr, "usage:\n"
+			 "\tjedec-notes [-k <kind>] <jedec-file> ...\n"
+			 "\n"
+			 "\t-k  show NOTEs of the specified kind only: "
+			 "pt, mux or switch\n");
+	return 1;
+}
+
+int main (int argc, char *argv[])
+{
+	int opt, kind = 0, i, ok = 1;
+
+	while ((opt = getopt (argc, argv, "k:")) != -1)
+		switch (opt) {
+		case 'k':
+			if ((kind = parse_kind (optarg)) < 0)
+				return usage ();
+
+			break;
+		default:
+			return usage ();
+		}
+
+	if (optind >= argc)
+		return usage ();
+
+	printf ("file,kind,block,index,aux,addr,count,fuses\n");
+
+	for (i = optind; i < argc; ++i)
+		ok &= dump (argv[i], kind);
+
+	return ok ? 0 : 1;
+}
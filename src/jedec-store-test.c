@@ -0,0 +1,186 @@
+/*
+ * Dakota JEDEC Snapshot Store Test
+ *
+ * Copyright (c) 2025 Alexei A. Smekalkine <ikle@ikle.ru>
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <dakota/jedec.h>
+
+#define SAMPLES	8
+
+static struct jedec *make_map (size_t count, unsigned seed, size_t changes)
+{
+	struct jedec *o;
+	size_t i, addr;
+
+	if ((o = jedec_alloc ("ATF1502AS")) == NULL ||
+	    !jedec_set_count (o, count) || !jedec_set_default (o, 0))
+		goto error;
+
+	srand (1);				/* the same base for all */
+
+	for (i = 0; i < count; i += 1 + rand () % 61)
+		jedec_set_bits (o, i, 1, 1);
+
+	srand (seed);
+
+	for (i = 0; i < changes; ++i) {
+		addr = (size_t) rand () % count;
+		jedec_set_bits (o, addr, 1, !jedec_get_bits (o, addr, 1));
+	}
+
+	return o;
+error:
+	jedec_free (o);
+	return NULL;
+}
+
+/*
+ * Difference lists: address and both fuse states of every change
+ */
+struct diff {
+	size_t count, size;
+	size_t *item;
+};
+
+static int collect (void *cookie, size_t addr, int a, int b)
+{
+	struct diff *o = cookie;
+	size_t *p;
+
+	if (o->count == o->size) {
+		o->size = o->size == 0 ? 64 : o->size * 2;
+
+		if ((p = realloc (o->item, o->size * sizeof (p[0]))) == NULL)
+			return 0;
+
+		o->item = p;
+	}
+
+	o->item[o->count++] = addr * 4 + a * 2 + b;
+	return 1;
+}
+
+static int stop (void *cookie, size_t addr, int a, int b)
+{
+	return 0;
+}
+
+static int same_diff (const struct diff *a, const struct diff *b)
+{
+	return a->count == b->count &&
+	       (a->count == 0 ||
+		memcmp (a->item, b->item, a->count * sizeof (a->item[0])) == 0);
+}
+
+static int check_store (size_t count)
+{
+	struct jedec *base, *map[SAMPLES], *s;
+	struct jedec_store *o;
+	struct diff da = { 0 }, db = { 0 };
+	size_t i, j, n;
+	int ok = 1;
+
+	if ((base = make_map (count, 0, 0)) == NULL ||
+	    (o = jedec_store_alloc (base)) == NULL) {
+		perror ("E: make store");
+		return 0;
+	}
+
+	if (jedec_store_diff (o, 0, 0, NULL, NULL) != (size_t) -1 ||
+	    errno != EINVAL) {			/* empty store, no deltas */
+		fprintf (stderr, "E: %zu: empty store accepts index\n", count);
+		ok = 0;
+	}
+
+	for (i = 0; i < SAMPLES; ++i)
+		if ((map[i] = make_map (count, i + 2, i * 7)) == NULL ||
+		    jedec_store_add (o, map[i]) != i) {
+			perror ("E: add sample");
+			return 0;
+		}
+
+	for (i = 0; ok && i < SAMPLES; ++i) {
+		if ((s = jedec_store_get (o, i)) == NULL ||
+		    jedec_diff (s, map[i], NULL, NULL, NULL) != 0) {
+			fprintf (stderr, "E: %zu: get %zu differs\n", count, i);
+			ok = 0;
+		}
+
+		jedec_free (s);
+
+		if ((s = make_map (count, 0, 0)) == NULL ||
+		    !jedec_store_apply (o, i, s) ||
+		    jedec_diff (s, map[i], NULL, NULL, NULL) != 0 ||
+		    !jedec_store_apply (o, i, s) ||
+		    jedec_diff (s, base, NULL, NULL, NULL) != 0) {
+			fprintf (stderr, "E: %zu: apply %zu differs\n", count, i);
+			ok = 0;
+		}
+
+		jedec_free (s);
+
+		for (j = 0; ok && j < SAMPLES; ++j) {
+			da.count = db.count = 0;
+
+			n = jedec_store_diff (o, i, j, collect, &da);
+
+			if (n != jedec_diff (map[i], map[j], NULL, collect, &db) ||
+			    n != da.count || !same_diff (&da, &db)) {
+				fprintf (stderr, "E: %zu: diff %zu, %zu differs\n",
+					 count, i, j);
+				ok = 0;
+			}
+		}
+	}
+
+	n = jedec_diff (map[0], map[SAMPLES - 1], NULL, NULL, NULL);
+
+	if (ok && n > 0 &&
+	    (jedec_diff (map[0], map[SAMPLES - 1], NULL, stop, NULL) !=
+	     (size_t) -1 || errno != ECANCELED ||
+	     jedec_store_diff (o, 0, SAMPLES - 1, stop, NULL) != (size_t) -1 ||
+	     errno != ECANCELED)) {
+		fprintf (stderr, "E: %zu: aborted diff is not reported\n", count);
+		ok = 0;
+	}
+
+	if (ok && (jedec_store_get (o, SAMPLES) != NULL || errno != EINVAL ||
+		   jedec_store_apply (o, SAMPLES, base) || errno != EINVAL ||
+		   jedec_store_diff (o, 0, SAMPLES, NULL, NULL) != (size_t) -1 ||
+		   errno != EINVAL)) {
+		fprintf (stderr, "E: %zu: index out of range accepted\n", count);
+		ok = 0;
+	}
+
+	free (db.item);
+	free (da.item);
+
+	for (i = 0; i < SAMPLES; ++i)
+		jedec_free (map[i]);
+
+	jedec_store_free (o);
+	jedec_free (base);
+	return ok;
+}
+
+int main (int argc, char *argv[])
+{
+	static const size_t count[] = { 1, 63, 64, 65, 16808, 74919 };
+	const size_t n = sizeof (count) / sizeof (count[0]);
+	size_t i;
+	int ok = 1;
+
+	for (i = 0; i < n; ++i)
+		ok &= check_store (count[i]);
+
+	printf ("I: snapshot store %s\n", ok ? "ok" : "failed");
+	return ok ? 0 : 1;
+}
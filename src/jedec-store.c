@@ -0,0 +1,262 @@
+/*
+ * Dakota JEDEC Base-plus-Delta Snapshot Store
+ *
+ * Copyright (c) 2025 Alexei A. Smekalkine <ikle@ikle.ru>
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "jedec-map.h"
+
+struct jedec_delta {
+	size_t count;		/* number of fuses changed		*/
+	const uint32_t *addr;	/* sorted addresses of changed fuses	*/
+};
+
+struct jedec_store {
+	struct jedec *base;
+
+	size_t count, size;	/* snapshots and available space	*/
+	struct jedec_delta *delta;
+
+	struct arena store;	/* address lists of all deltas		*/
+
+	size_t used, space;	/* scratch list for jedec_store_add	*/
+	uint32_t *scratch;
+};
+
+struct jedec_store *jedec_store_alloc (struct jedec *base)
+{
+	struct jedec_store *o;
+
+	if (base->fuses == NULL || base->count > UINT32_MAX) {
+		errno = EINVAL;
+		return NULL;
+	}
+
+	if ((o = calloc (1, sizeof (*o))) == NULL)
+		return NULL;
+
+	if ((o->base = jedec_alloc (base->device)) == NULL ||
+	    !jedec_set_count (o->base, base->count))
+		goto error;
+
+	o->base->def = base->def;
+	memcpy (o->base->fuses, base->fuses, jedec_words (base) * 8);
+
+	arena_init (&o->store);
+	return o;
+error:
+	jedec_free (o->base);
+	free (o);
+	return NULL;
+}
+
+void jedec_store_free (struct jedec_store *o)
+{
+	if (o == NULL)
+		return;
+
+	free (o->scratch);
+	arena_fini (&o->store);
+	free (o->delta);
+	jedec_free (o->base);
+	free (o);
+}
+
+struct jedec *jedec_store_get_base (struct jedec_store *o)
+{
+	return o->base;
+}
+
+size_t jedec_store_count (struct jedec_store *o)
+{
+	return o->count;
+}
+
+static int collect (void *cookie, size_t addr, int a, int b)
+{
+	struct jedec_store *o = cookie;
+	const size_t next = o->space == 0 ? 64 : o->space * 2;
+	uint32_t *p;
+
+	if (o->used >= o->space) {
+		if (next > (size_t) -1 / sizeof (p[0])) {
+			errno = ENOMEM;  /* size overflow */
+			return 0;
+		}
+
+		if ((p = realloc (o->scratch, next * sizeof (p[0]))) == NULL)
+			return 0;
+
+		o->scratch = p;
+		o->space   = next;
+	}
+
+	o->scratch[o->used++] = addr;
+	return 1;
+}
+
+static int jedec_store_resize (struct jedec_store *o)
+{
+	struct jedec_delta *p;
+	const size_t next = o->size == 0 ? 16 : o->size * 2;
+
+	if (next < o->size || next > (size_t) -1 / sizeof (p[0])) {
+		errno = ENOMEM;  /* size overflow */
+		return 0;
+	}
+
+	if ((p = realloc (o->delta, next * sizeof (p[0]))) == NULL)
+		return 0;
+
+	o->delta = p;
+	o->size  = next;
+	return 1;
+}
+
+size_t jedec_store_add (struct jedec_store *o, struct jedec *sample)
+{
+	struct jedec_delta *d;
+	uint32_t *addr = NULL;
+
+	if (o->count >= o->size && !jedec_store_resize (o))
+		return -1;
+
+	o->used = 0;
+
+	if (jedec_diff (o->base, sample, NULL, collect, o) == -1)
+		return -1;
+
+	if (o->used > 0) {
+		if ((addr = arena_alloc (&o->store, o->used * sizeof (addr[0]))) == NULL)
+			return -1;
+
+		memcpy (addr, o->scratch, o->used * sizeof (addr[0]));
+	}
+
+	d = o->delta + o->count;
+	d->count = o->used;
+	d->addr  = addr;
+	return o->count++;
+}
+
+size_t jedec_store_get_delta (struct jedec_store *o, size_t i,
+			      const uint32_t **addr)
+{
+	if (i >= o->count) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	*addr = o->delta[i].addr;
+	return o->delta[i].count;
+}
+
+int jedec_store_apply (struct jedec_store *o, size_t i, struct jedec *to)
+{
+	const struct jedec_delta *d;
+	size_t k;
+	uint64_t x;
+
+	if (i >= o->count || to->fuses == NULL || to->count != o->base->count) {
+		errno = EINVAL;
+		return 0;
+	}
+
+	d = o->delta + i;
+
+	for (k = 0; k < d->count; ++k) {
+		x = load_word (to, d->addr[k] / 64);
+		store_word (to, d->addr[k] / 64, x ^ (uint64_t) 1 << (d->addr[k] & 63));
+	}
+
+	return 1;
+}
+
+struct jedec *jedec_store_get (struct jedec_store *o, size_t i)
+{
+	struct jedec *s;
+
+	if (i >= o->count) {
+		errno = EINVAL;
+		return NULL;
+	}
+
+	if ((s = jedec_alloc (o->base->device)) == NULL ||
+	    !jedec_set_count (s, o->base->count))
+		goto error;
+
+	s->def = o->base->def;
+	memcpy (s->fuses, o->base->fuses, jedec_words (s) * 8);
+
+	if (!jedec_store_apply (o, i, s))
+		goto error;
+
+	return s;
+error:
+	jedec_free (s);
+	return NULL;
+}
+
+static int base_bit (struct jedec_store *o, size_t addr)
+{
+	return load_word (o->base, addr / 64) >> (addr & 63) & 1;
+}
+
+size_t jedec_store_diff (struct jedec_store *o, size_t i, size_t j,
+			 jedec_diff_fn *fn, void *cookie)
+{
+	const struct jedec_delta *a, *b;
+	size_t ia = 0, ib = 0, total = 0, addr;
+	int va, vb;
+
+	if (i >= o->count || j >= o->count) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	a = o->delta + i;
+	b = o->delta + j;
+
+	/* fuses differ where exactly one of the deltas changes them */
+
+	while (ia < a->count || ib < b->count) {
+		if (ib == b->count ||
+		    (ia < a->count && a->addr[ia] < b->addr[ib])) {
+			addr = a->addr[ia++];
+			va = !base_bit (o, addr);
+			vb = !va;
+		}
+		else if (ia == a->count || b->addr[ib] < a->addr[ia]) {
+			addr = b->addr[ib++];
+			vb = !base_bit (o, addr);
+			va = !vb;
+		}
+		else {
+			++ia, ++ib;
+			continue;
+		}
+
+		++total;
+
+		if (fn == NULL)
+			continue;
+
+		errno = 0;
+
+		if (!fn (cookie, addr, va, vb))
+			goto no_fn;
+	}
+
+	return total;
+no_fn:
+	if (errno == 0)
+		errno = ECANCELED;
+
+	return -1;
+}
@@ -28,10 +28,25 @@ int main (int argc, char *argv[])
 
 	printf ("I: device %s\n", jedec_get_device (o));
 	printf ("I: total %zu fuses\n", jedec_get_count (o));
+	printf ("I: checksum %04X\n", jedec_get_checksum (o));
 
-	if (argc > 2)
-		jedec_save (o, argv[2]);
+	if (argc > 2 && !jedec_save (o, argv[2]))
+		goto error;
 
 	jedec_free (o);
+
+	if (argc > 2) {		/* verify checksums of the saved file */
+		if ((o = jedec_load_ex (argv[2], JEDEC_STRICT)) == NULL) {
+			perror ("E");
+			return 1;
+		}
+
+		jedec_free (o);
+	}
+
 	return 0;
+error:
+	perror ("E");
+	jedec_free (o);
+	return 1;
 }
@@ -8,19 +8,29 @@
 
 #include <ctype.h>
 #include <errno.h>
+#include <stdarg.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
-#include <dakota/jedec.h>
+#include "bitpack.h"
+#include "fmap.h"
+#include "jedec-map.h"
 
-struct jedec {
-	char device[32];
+void jedec_init (struct jedec *o, const char *device, struct arena *arena)
+{
+	jedec_set_device (o, device);
 
-	int def;
-	size_t count;
-	void *fuses;
-};
+	o->def   = 0;
+	o->count = 0;
+	o->fuses = NULL;
+	o->arena = arena;
+
+	o->notes = 0;
+	o->nsize = 0;
+	o->note  = NULL;
+}
 
 struct jedec *jedec_alloc (const char *device)
 {
@@ -29,12 +39,7 @@ struct jedec *jedec_alloc (const char *device)
 	if ((o = malloc (sizeof (*o))) == NULL)
 		return NULL;
 
-	jedec_set_device (o, device);
-
-	o->def   = 0;
-	o->count = 0;
-	o->fuses = NULL;
-
+	jedec_init (o, device, NULL);
 	return o;
 }
 
@@ -43,7 +48,10 @@ void jedec_free (struct jedec *o)
 	if (o == NULL)
 		return;
 
-	free (o->fuses);
+	if (o->arena == NULL)
+		free (o->fuses);
+
+	jedec_note_fini (o);
 	free (o);
 }
 
@@ -80,16 +88,26 @@ static void jedec_fuses_init (struct jedec *o)
 		fuses[full] = mask >> (8 - tail);
 }
 
+/*
+ * Fuse array is allocated in whole 64-bit words to allow word access to
+ * any fuse, the padding bits are always zero.
+ */
 int jedec_set_count (struct jedec *o, size_t count)
 {
-	const size_t len = (count + 7) / 8;
+	const size_t words = count / 64 + ((count & 63) != 0);
 
 	if (o->fuses != NULL) {
 		errno = EINVAL;
 		return 0;
 	}
 
-	if ((o->fuses = malloc (len)) == NULL)
+	if (o->arena == NULL)
+		o->fuses = calloc (words, sizeof (uint64_t));
+	else if (words <= (size_t) -1 / sizeof (uint64_t) &&
+		 (o->fuses = arena_alloc (o->arena, words * 8)) != NULL)
+		memset (o->fuses, 0, words * 8);
+
+	if (o->fuses == NULL)
 		return 0;
 
 	o->count = count;
@@ -114,172 +132,595 @@ int jedec_set_device (struct jedec *o, const char *device)
 	return 1;
 }
 
-static int jedec_set_bit (struct jedec *o, size_t addr, int on)
+static inline uint64_t width_mask (unsigned width)
 {
-	unsigned char *fuses = o->fuses;
-	const size_t i = addr / 8;
-	const unsigned mask = 1u << (addr & 7);
+	return width < 64 ? ((uint64_t) 1 << width) - 1 : ~(uint64_t) 0;
+}
 
-	if (addr >= o->count) {
+static int jedec_check_range (struct jedec *o, size_t addr, size_t count)
+{
+	if (o->fuses == NULL || addr > o->count || count > o->count - addr) {
 		errno = EFAULT;
 		return 0;
 	}
 
-	if (on)
-		fuses[i] |= mask;
-	else
-		fuses[i] &= ~mask;
+	return 1;
+}
+
+static uint64_t get_bits (const struct jedec *o, size_t addr, unsigned width)
+{
+	const size_t   i = addr / 64;
+	const unsigned s = addr & 63;
+	uint64_t x = load_word (o, i) >> s;
+
+	if (s + width > 64)
+		x |= load_word (o, i + 1) << (64 - s);
+
+	return x & width_mask (width);
+}
+
+static void set_bits (struct jedec *o, size_t addr, unsigned width,
+		      uint64_t value)
+{
+	const size_t   i = addr / 64;
+	const unsigned s = addr & 63;
+	const uint64_t m = width_mask (width);
+
+	value &= m;
+	store_word (o, i, (load_word (o, i) & ~(m << s)) | value << s);
+
+	if (s + width > 64)
+		store_word (o, i + 1, (load_word (o, i + 1) & ~(m >> (64 - s))) |
+				      value >> (64 - s));
+}
+
+uint64_t jedec_get_bits (struct jedec *o, size_t addr, unsigned width)
+{
+	if (width > 64 || !jedec_check_range (o, addr, width))
+		return 0;
+
+	return width == 0 ? 0 : get_bits (o, addr, width);
+}
+
+int jedec_set_bits (struct jedec *o, size_t addr, unsigned width,
+		    uint64_t value)
+{
+	if (width > 64 || !jedec_check_range (o, addr, width))
+		return 0;
+
+	if (width > 0)
+		set_bits (o, addr, width, value);
+
+	return 1;
+}
+
+int jedec_get_range (struct jedec *o, size_t addr, size_t count, uint64_t *to)
+{
+	if (!jedec_check_range (o, addr, count))
+		return 0;
+
+	for (; count >= 64; addr += 64, count -= 64)
+		*to++ = get_bits (o, addr, 64);
+
+	if (count > 0)
+		*to = get_bits (o, addr, count);
 
 	return 1;
 }
 
-static int jedec_read_bits (struct jedec *o, size_t addr, const char *s)
+int jedec_set_range (struct jedec *o, size_t addr, size_t count,
+		     const uint64_t *from)
 {
-	int ok = 1;
+	if (!jedec_check_range (o, addr, count))
+		return 0;
 
-	for (; *s != '\0'; ++s)
-		switch (*s) {
-		case '0':
-			ok &= jedec_set_bit (o, addr++, 0);
-			break;
+	for (; count >= 64; addr += 64, count -= 64)
+		set_bits (o, addr, 64, *from++);
 
-		case '1':
-			ok &= jedec_set_bit (o, addr++, 1);
-			break;
+	if (count > 0)
+		set_bits (o, addr, count, *from);
+
+	return 1;
+}
+
+int jedec_copy_range (struct jedec *o, size_t to, struct jedec *src,
+		      size_t from, size_t count)
+{
+	size_t i, n;
+
+	if (!jedec_check_range (o, to, count) ||
+	    !jedec_check_range (src, from, count))
+		return 0;
+
+	if (o == src && to > from && to < from + count) {  /* copy backward */
+		for (i = count; i > 0; i -= n) {
+			n = i < 64 ? i : 64;
+			set_bits (o, to + i - n, n, get_bits (src, from + i - n, n));
 		}
 
-	return ok;
+		return 1;
+	}
+
+	for (i = 0; i < count; i += n) {
+		n = count - i < 64 ? count - i : 64;
+		set_bits (o, to + i, n, get_bits (src, from + i, n));
+	}
+
+	return 1;
 }
 
-static struct jedec *jedec_read (FILE *in)
+size_t jedec_diff (struct jedec *a, struct jedec *b, struct jedec *mask,
+		   jedec_diff_fn *fn, void *cookie)
 {
-	char device[32];
-	struct jedec *o;
-	int c;
-	char *line = NULL;
-	size_t avail = 0, n;
-	ssize_t len;
+	const size_t words = jedec_words (a);
+	size_t i, total = 0;
+	uint64_t wa, wb, x;
+	unsigned bit;
 
-	if ((o = jedec_alloc ("")) == NULL)
-		return NULL;
+	if (a->count != b->count || a->fuses == NULL || b->fuses == NULL ||
+	    (mask != NULL && (mask->count != a->count || mask->fuses == NULL))) {
+		errno = EINVAL;
+		return -1;
+	}
 
-	while ((c = fgetc (in)) != 2)
-		if (c == EOF)
-			goto error;
+	for (i = 0; i < words; ++i) {
+		wa = load_word (a, i);
+		wb = load_word (b, i);
 
-	while ((c = fgetc (in)) != 3) {
-		if (c == EOF)
-			goto error;
+		if ((x = wa ^ wb) == 0)
+			continue;
 
-		if (isspace (c))
+		if (mask != NULL && (x &= ~load_word (mask, i)) == 0)
 			continue;
 
-		if ((len = getdelim (&line, &avail, '*', in)) < 1)
-			goto error;
+		total += __builtin_popcountll (x);
 
-		line[len - 1] = '\0';
+		for (; fn != NULL && x != 0; x &= x - 1) {
+			bit = __builtin_ctzll (x);
 
-		switch (c) {
-		case 'J':  /* to do: run for first block only */
-			if (sscanf (line, "EDEC file for: %31s", device) == 1)
-				jedec_set_device (o, device);
+			errno = 0;
 
-			break;
+			if (!fn (cookie, i * 64 + bit, wa >> bit & 1, wb >> bit & 1))
+				goto no_fn;
+		}
+	}
 
-		case 'N':
-			if (sscanf (line, " DEVICE %31s", device) == 1)
-				jedec_set_device (o, device);
+	return total;
+no_fn:
+	if (errno == 0)
+		errno = ECANCELED;
 
-			break;
+	return -1;
+}
 
-		case 'Q':
-			if (sscanf (line, "F%zu", &n) == 1 &&
-			    !jedec_set_count (o, n))
-				goto error;
+/*
+ * Field scanners: all of them work on the [s, e) range of a field body and
+ * follow the rules of the scanf conversions used originally: white space
+ * in a literal matches any amount of white space, numbers and words may be
+ * preceded by white space.
+ */
+static const char *skip_space (const char *s, const char *e)
+{
+	for (; s < e && isspace ((unsigned char) *s); ++s) {}
 
-			break;
+	return s;
+}
+
+static const char *scan_literal (const char *s, const char *e, const char *p)
+{
+	for (; *p != '\0'; ++p)
+		if (isspace ((unsigned char) *p))
+			s = skip_space (s, e);
+		else if (s < e && *s == *p)
+			++s;
+		else
+			return NULL;
+
+	return s;
+}
 
-		case 'F':
-			if (sscanf (line, "%d", &c) != 1 ||
-			    !jedec_set_default (o, c))
-				goto error;
+static const char *scan_size (const char *s, const char *e, size_t *n)
+{
+	const char *start;
+	size_t v = 0;
 
-			break;
+	for (start = s = skip_space (s, e); s < e && isdigit ((unsigned char) *s); ++s)
+		v = v * 10 + (*s - '0');
 
-		case 'L':
-			if (o->fuses == NULL ||
-			    sscanf (line, "%zu %n", &n, &c) != 1 ||
-			    !jedec_read_bits (o, n, line + c))
-				goto error;
+	if (s == start)
+		return NULL;
+
+	*n = v;
+	return s;
+}
 
+static int scan_word (const char *s, const char *e, char *to, size_t size)
+{
+	size_t i;
+
+	for (s = skip_space (s, e), i = 0; s < e && i + 1 < size; ++s, ++i) {
+		if (isspace ((unsigned char) *s))
 			break;
+
+		to[i] = *s;
+	}
+
+	to[i] = '\0';
+	return i > 0;
+}
+
+static int jedec_read_bits (struct jedec *o, size_t *next, const char *s,
+			    const char *e)
+{
+	size_t addr = *next;
+	char tail[64];
+	uint64_t valid, ones;
+	size_t len;
+	unsigned n;
+
+	/* pack runs of fuse characters 64 at a time, skip separators */
+
+	for (; s < e; s += n < 64 ? n + 1 : n) {
+		if ((len = e - s) < 64) {  /* pad the tail to a full block */
+			memmove (tail, s, len);
+			memset (tail + len, ' ', sizeof (tail) - len);
+			s = tail;
+			e = tail + len;
+		}
+
+		valid = bitpack_read (s, &ones);
+		n = ~valid == 0 ? 64 : __builtin_ctzll (~valid);
+
+		if (n > 0 && !jedec_set_bits (o, addr, n, ones))
+			return 0;
+
+		addr += n;
+	}
+
+	*next = addr;
+	return 1;
+}
+
+static const char *scan_hex (const char *s, const char *e, unsigned *n)
+{
+	const char *start;
+	unsigned v = 0;
+
+	for (start = s = skip_space (s, e); s < e && isxdigit ((unsigned char) *s); ++s)
+		v = v * 16 + (isdigit ((unsigned char) *s) ? *s - '0' :
+							     (*s | 0x20) - 'a' + 10);
+
+	if (s == start)
+		return NULL;
+
+	*n = v;
+	return s;
+}
+
+struct jedec_parser {
+	int flags;
+	long csum;		/* fuse checksum from C field		*/
+	size_t addr, count;	/* fuse range of the last L field	*/
+};
+
+/*
+ * Parses a NOTE describing the preceding L record, recognizes the forms
+ * "PT n of MC m", "Mux-n of block X" and "Sa, Sb of block X".
+ */
+static int jedec_read_note (struct jedec *o, const struct jedec_parser *p,
+			    const char *s, const char *e)
+{
+	struct jedec_note note = { 0 };
+	const char *t;
+	size_t a, b;
+
+	if ((t = scan_literal (s, e, " PT")) != NULL) {
+		if ((t = scan_size (t, e, &a)) == NULL ||
+		    (t = scan_literal (t, e, " of MC")) == NULL ||
+		    scan_size (t, e, &b) == NULL)
+			return 1;
+
+		note.kind  = JEDEC_NOTE_PT;
+		note.block = b;
+	}
+	else if ((t = scan_literal (s, e, " Mux-")) != NULL) {
+		if ((t = scan_size (t, e, &a)) == NULL ||
+		    (t = scan_literal (t, e, " of block ")) == NULL ||
+		    t == e || !isupper ((unsigned char) *t))
+			return 1;
+
+		note.kind  = JEDEC_NOTE_MUX;
+		note.block = *t - 'A';
+	}
+	else if ((t = scan_literal (s, e, " S")) != NULL) {
+		if ((t = scan_size (t, e, &a)) == NULL ||
+		    (t = scan_literal (t, e, " , S")) == NULL ||
+		    (t = scan_size (t, e, &b)) == NULL ||
+		    (t = scan_literal (t, e, " of block ")) == NULL ||
+		    t == e || !isupper ((unsigned char) *t))
+			return 1;
+
+		note.kind  = JEDEC_NOTE_SWITCH;
+		note.block = *t - 'A';
+		note.aux   = b;
+	}
+	else
+		return 1;
+
+	note.index = a;
+	note.addr  = p->addr;
+	note.count = p->count;
+
+	return jedec_note_add (o, &note);
+}
+
+static int jedec_read_field (struct jedec *o, struct jedec_parser *p, int c,
+			     const char *s, const char *e)
+{
+	const size_t count = p->count;
+	const char *note;
+	unsigned x;
+	char device[32];
+	size_t n;
+
+	p->count = 0;	/* L field range is valid for the next field only */
+
+	switch (c) {
+	case 'J':  /* to do: run for first block only */
+		if ((s = scan_literal (s, e, "EDEC file for:")) != NULL &&
+		    scan_word (s, e, device, sizeof (device)))
+			jedec_set_device (o, device);
+
+		return 1;
+
+	case 'N':
+		if ((p->flags & JEDEC_NOTES) != 0 &&
+		    (note = scan_literal (s, e, "OTE")) != NULL) {
+			p->count = count;
+			n = count == 0 || jedec_read_note (o, p, note, e);
+			p->count = 0;
+			return n;
+		}
+
+		if ((s = scan_literal (s, e, " DEVICE")) != NULL &&
+		    scan_word (s, e, device, sizeof (device)))
+			jedec_set_device (o, device);
+
+		return 1;
+
+	case 'Q':
+		if (s < e && *s == 'F' && scan_size (s + 1, e, &n) != NULL)
+			return jedec_set_count (o, n);
+
+		return 1;
+
+	case 'F':
+		return scan_size (s, e, &n) != NULL &&
+		       jedec_set_default (o, n > 1 ? -1 : n);
+
+	case 'L':
+		if (o->fuses == NULL || (s = scan_size (s, e, &p->addr)) == NULL)
+			return 0;
+
+		n = p->addr;
+
+		if (!jedec_read_bits (o, &n, s, e))
+			return 0;
+
+		p->count = n - p->addr;
+		return 1;
+
+	case 'C':
+		if (scan_hex (s, e, &x) != NULL)
+			p->csum = x & 0xffff;
+
+		return 1;
+	}
+
+	return 1;
+}
+
+/*
+ * Returns the sum of all bytes of the data block. Bytes are summed eight at
+ * a time into 16-bit lanes, lanes are folded into the total before they can
+ * overflow.
+ */
+static uint64_t sum_bytes (const void *data, size_t size)
+{
+	const unsigned char *p = data;
+	const uint64_t m8 = 0x00ff00ff00ff00ffull, m16 = 0x0000ffff0000ffffull;
+	uint64_t x, acc, sum = 0;
+	size_t i, n;
+
+	for (; size >= 8; size -= n * 8) {
+		n = size / 8 < 128 ? size / 8 : 128;
+
+		for (acc = 0, i = 0; i < n; ++i, p += 8) {
+			memcpy (&x, p, sizeof (x));
+			acc += (x & m8) + ((x >> 8) & m8);
+		}
+
+		acc = (acc & m16) + ((acc >> 16) & m16);
+		sum += (acc & 0xffffffff) + (acc >> 32);
+	}
+
+	for (; size > 0; --size)
+		sum += *p++;
+
+	return sum;
+}
+
+unsigned jedec_get_checksum (struct jedec *o)
+{
+	const unsigned char *fuses = o->fuses;
+	const size_t   full = o->count / 8;
+	const unsigned tail = o->count & 7;
+	uint64_t sum;
+
+	if (fuses == NULL)
+		return 0;
+
+	sum = sum_bytes (fuses, full);
+
+	if (tail != 0)
+		sum += fuses[full] & (0xff >> (8 - tail));
+
+	return sum & 0xffff;
+}
+
+static int jedec_verify (struct jedec *o, long csum, const char *stx,
+			 const char *etx, const char *e)
+{
+	unsigned tsum;
+
+	if (csum >= 0 && csum != jedec_get_checksum (o))
+		return 0;
+
+	if (e - (etx + 1) < 4 || scan_hex (etx + 1, etx + 5, &tsum) != etx + 5)
+		return 1;  /* no transmission checksum */
+
+	return tsum == 0 || tsum == (sum_bytes (stx, etx + 1 - stx) & 0xffff);
+}
+
+int jedec_parse (struct jedec *o, const void *data, size_t size, int flags)
+{
+	const char *s = data, *e = s + size, *stx, *end;
+	struct jedec_parser p = { flags, -1, 0, 0 };
+	int c;
+
+	if ((stx = s = memchr (s, 2, size)) == NULL)	/* STX */
+		goto error;
+
+	for (++s; s < e && (c = (unsigned char) *s) != 3; s = end + 1) {
+		if (isspace (c)) {
+			end = s;
+			continue;
 		}
+
+		if ((end = memchr (s + 1, '*', e - (s + 1))) == NULL ||
+		    !jedec_read_field (o, &p, c, s + 1, end))
+			goto error;
+	}
+
+	if (s == e)					/* no ETX */
+		goto error;
+
+	if ((flags & JEDEC_STRICT) != 0 && !jedec_verify (o, p.csum, stx, s, e)) {
+		errno = EBADMSG;
+		return 0;
 	}
 
-	free (line);
+	jedec_note_sort (o);
+	return 1;
+error:
+	errno = EILSEQ;
+	return 0;
+}
+
+struct jedec *jedec_load_mem (const void *data, size_t size, int flags)
+{
+	struct jedec *o;
+
+	if ((o = jedec_alloc ("")) == NULL)
+		return NULL;
+
+	if (!jedec_parse (o, data, size, flags))
+		goto error;
+
 	return o;
 error:
-	free (line);
 	jedec_free (o);
-	errno = EILSEQ;
 	return NULL;
 }
 
-static int jedec_write_bits (FILE *out, const unsigned char *data, size_t count)
+/*
+ * Output stream that accumulates the transmission checksum of all the
+ * data written.
+ */
+struct jedec_out {
+	FILE *file;
+	uint64_t sum;
+	int ok;
+};
+
+static void jedec_put (struct jedec_out *o, const char *data, size_t count)
 {
-	size_t i;
-	int c, ok = 1;
+	o->sum += sum_bytes (data, count);
+	o->ok  &= fwrite (data, count, 1, o->file) == 1;
+}
 
-	for (i = 0; i < count; ++i) {
-		c = (data[i / 8] & 1u << (i & 7)) != 0 ? '1' : '0';
-		ok &= fputc (c, out) != EOF;
+static void jedec_printf (struct jedec_out *o, const char *fmt, ...)
+{
+	char line[64];
+	va_list ap;
+	int len;
+
+	va_start (ap, fmt);
+	len = vsnprintf (line, sizeof (line), fmt, ap);
+	va_end (ap);
+
+	if (len < 0 || len >= sizeof (line)) {
+		o->ok = 0;
+		return;
 	}
 
-	return ok;
+	jedec_put (o, line, len);
 }
 
-static int jedec_write (struct jedec *o, FILE *out)
+static void jedec_write_bits (struct jedec_out *out, const unsigned char *data,
+			      size_t addr, size_t count)
+{
+	char line[24 + 64 + 2];
+	int len = snprintf (line, 24, "L%06zu ", addr);
+
+	bitpack_write (line + len, data, count);
+	memcpy (line + len + count, "*\n", 2);
+
+	jedec_put (out, line, len + count + 2);
+}
+
+static int jedec_write (struct jedec *o, FILE *file)
 {
 	const unsigned char *fuses = o->fuses;
+	struct jedec_out out = { file, 0, 1 };
 	size_t i, count;
-	int ok;
 
-	ok = fprintf (out, "\002" "QF%zu*\n" "F%u*\n", o->count, o->def) > 0;
+	jedec_printf (&out, "\002" "QF%zu*\n" "F%u*\n", o->count, o->def);
 
 	if (o->device[0] != '\0')
-		ok &= fprintf (out, "N DEVICE %s*\n", o->device) > 0;
+		jedec_printf (&out, "N DEVICE %s*\n", o->device);
 
-	for (i = 0, count = o->count; count >= 64; i += 8, count -= 64) {
-		ok &= fprintf (out, "L%06zu ", i * 8) > 0;
-		ok &= jedec_write_bits (out, fuses + i, 64);
-		ok &= fprintf (out, "*\n") > 0;
-	}
+	for (i = 0, count = o->count; count >= 64; i += 8, count -= 64)
+		jedec_write_bits (&out, fuses + i, i * 8, 64);
 
-	if (count > 0) {
-		ok &= fprintf (out, "L%06zu ", i * 8) > 0;
-		ok &= jedec_write_bits (out, fuses + i, count);
-		ok &= fprintf (out, "*\n") > 0;
-	}
+	if (count > 0)
+		jedec_write_bits (&out, fuses + i, i * 8, count);
 
-	ok &= fprintf (out, "C0000*\0030000\n");
+	jedec_printf (&out, "C%04X*\003", jedec_get_checksum (o));
 
-	return ok;
+	return out.ok &&
+	       fprintf (file, "%04X\n", (unsigned) (out.sum & 0xffff)) > 0;
 }
 
-struct jedec *jedec_load (const char *path)
+struct jedec *jedec_load_ex (const char *path, int flags)
 {
-	FILE *in;
+	struct fmap m;
 	struct jedec *o;
 
-	if ((in = fopen (path, "rb")) == NULL)
-		return 0;
+	if (!fmap_open (&m, path))
+		return NULL;
 
-	o = jedec_read (in);
+	o = jedec_load_mem (m.data, m.size, flags);
 
-	fclose (in);
+	fmap_close (&m);
 	return o;
 }
 
+struct jedec *jedec_load (const char *path)
+{
+	return jedec_load_ex (path, 0);
+}
+
 int jedec_save (struct jedec *o, const char *path)
 {
 	FILE *out;
@@ -0,0 +1,301 @@
+/*
+ * Pattern Set Automaton
+ *
+ * Copyright (c) 2025 Alexei A. Smekalkine <ikle@ikle.ru>
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "patauto.h"
+
+/*
+ * States with this number of transitions or more (and the root) get a
+ * dense row of 256 transitions with failures resolved in advance, other
+ * states keep a short sorted list of transitions
+ */
+#define PATAUTO_DENSE	8
+
+void patauto_init (struct patauto *o, struct patset *P)
+{
+	o->P      = P;
+	o->serial = 0;
+	o->valid  = 0;
+	o->count  = 0;
+	o->state  = NULL;
+	o->label  = NULL;
+	o->to     = NULL;
+	o->row    = NULL;
+}
+
+static void patauto_reset (struct patauto *o)
+{
+	free (o->row);
+	free (o->to);
+	free (o->label);
+	free (o->state);
+
+	patauto_init (o, o->P);
+}
+
+void patauto_fini (struct patauto *o)
+{
+	patauto_reset (o);
+}
+
+static int32_t find_edge (const struct patauto *o, int32_t s, unsigned c)
+{
+	const struct patauto_state *st = o->state + s;
+	uint32_t i;
+
+	for (i = st->edge; i < st->edge + st->edges; ++i)
+		if (o->label[i] >= c)
+			return o->label[i] == c ? o->to[i] : -1;
+
+	return -1;
+}
+
+static inline int32_t patauto_next (const struct patauto *o, int32_t s,
+				    unsigned c)
+{
+	const struct patauto_state *st;
+	int32_t t;
+
+	for (;; s = st->fail) {
+		st = o->state + s;
+
+		if (st->row >= 0)
+			return o->row[st->row * 256 + c];
+
+		if ((t = find_edge (o, s, c)) >= 0)
+			return t;
+	}
+}
+
+/*
+ * Trie of the sorted pattern set: as every pattern shares a prefix with
+ * the previous one only, the child to follow is always the last child
+ */
+struct trie {
+	int32_t first, next, last;	/* first child, sibling, last child */
+	unsigned char c;		/* label of the incoming edge	*/
+	const struct pattern *p;	/* pattern ending here		*/
+};
+
+static int32_t trie_build (struct trie *t, const struct patset *P)
+{
+	int32_t n = 1, u, v;
+	size_t i, j;
+
+	t[0].first = t[0].next = t[0].last = -1;
+	t[0].p = NULL;
+
+	for (i = 0; i < P->count; ++i) {
+		const struct pattern *p = P->set + i;
+
+		for (j = 0, u = 0; j < p->len; ++j, u = v)
+			if ((v = t[u].last) < 0 ||
+			    t[v].c != (unsigned char) p->name[j]) {
+				v = n++;
+
+				t[v].first = t[v].next = t[v].last = -1;
+				t[v].c = p->name[j];
+				t[v].p = NULL;
+
+				if (t[u].last < 0)
+					t[u].first = v;
+				else
+					t[t[u].last].next = v;
+
+				t[u].last = v;
+			}
+
+		if (u > 0)
+			t[u].p = p;
+	}
+
+	return n;
+}
+
+/*
+ * Lays trie nodes out in breadth-first order: shallow (hot) states go
+ * first and transitions of every state are contiguous
+ */
+static void patauto_layout (struct patauto *o, const struct trie *t,
+			    int32_t *order)
+{
+	struct patauto_state *st;
+	int32_t head, tail = 1, u, v;
+	uint32_t edge = 0;
+
+	order[0] = 0;
+
+	for (head = 0; head < tail; ++head) {
+		u  = order[head];
+		st = o->state + head;
+
+		st->edge  = edge;
+		st->edges = 0;
+		st->out   = t[u].p;
+
+		for (v = t[u].first; v >= 0; v = t[v].next, ++edge) {
+			o->label[edge] = t[v].c;
+			o->to[edge]    = tail;
+
+			o->state[tail].depth = st->depth + 1;
+			order[tail++] = v;
+			++st->edges;
+		}
+	}
+}
+
+static void patauto_link (struct patauto *o)
+{
+	struct patauto_state *st = o->state, *c;
+	int32_t s, f, t;
+	uint32_t i;
+
+	st[0].fail = 0;
+
+	for (s = 0; s < o->count; ++s)
+		for (i = st[s].edge; i < st[s].edge + st[s].edges; ++i) {
+			c = st + o->to[i];
+
+			for (f = st[s].fail, t = 0; s > 0; f = st[f].fail)
+				if ((t = find_edge (o, f, o->label[i])) >= 0 ||
+				    f == 0)
+					break;
+
+			c->fail = t < 0 ? 0 : t;
+
+			if (c->out == NULL)
+				c->out = st[c->fail].out;
+		}
+}
+
+static int patauto_rows (struct patauto *o)
+{
+	struct patauto_state *st;
+	size_t rows = 0;
+	int32_t s, t;
+	unsigned c;
+
+	for (s = 0; s < o->count; ++s) {
+		st = o->state + s;
+		st->row = s == 0 || st->edges >= PATAUTO_DENSE ? rows++ : -1;
+	}
+
+	if ((o->row = malloc (rows * 256 * sizeof (o->row[0]))) == NULL)
+		return 0;
+
+	for (s = 0; s < o->count; ++s) {	/* failures go to rows above */
+		if ((st = o->state + s)->row < 0)
+			continue;
+
+		for (c = 0; c < 256; ++c)
+			o->row[st->row * 256 + c] =
+				(t = find_edge (o, s, c)) >= 0 ? t :
+				s == 0 ? 0 : patauto_next (o, st->fail, c);
+	}
+
+	return 1;
+}
+
+int patauto_compile (struct patauto *o)
+{
+	size_t i, total = 1;
+	struct trie *t;
+	int32_t *order;
+
+	if (o->valid && o->serial == o->P->serial)
+		return 1;
+
+	patauto_reset (o);
+	patset_sort (o->P);
+
+	for (i = 0; i < o->P->count; ++i)
+		if ((total += o->P->set[i].len) > INT32_MAX) {
+			errno = EOVERFLOW;
+			return 0;
+		}
+
+	if ((t = malloc (total * sizeof (t[0]))) == NULL)
+		return 0;
+
+	if ((order = malloc (total * sizeof (order[0]))) == NULL)
+		goto no_order;
+
+	o->count = trie_build (t, o->P);
+
+	if ((o->state = calloc (o->count, sizeof (o->state[0]))) == NULL ||
+	    (o->label = malloc (o->count)) == NULL ||
+	    (o->to    = malloc (o->count * sizeof (o->to[0]))) == NULL)
+		goto no_state;
+
+	patauto_layout (o, t, order);
+	patauto_link (o);
+
+	if (!patauto_rows (o))
+		goto no_state;
+
+	free (order);
+	free (t);
+
+	o->serial = o->P->serial;
+	o->valid  = 1;
+	return 1;
+no_state:
+	patauto_reset (o);
+	free (order);
+no_order:
+	free (t);
+	return 0;
+}
+
+/*
+ * The state path is the longest suffix of the scanned text that is a
+ * prefix of some pattern, thus no match can start before the state path
+ * does. The best match found so far is final as soon as the state path
+ * starts after it: then the match is replaced and the scan resumes right
+ * after it.
+ */
+int patauto_apply (struct patauto *o, const char *s, size_t len,
+		   struct spans *out)
+{
+	const struct pattern *best = NULL, *p;
+	const struct patauto_state *st;
+	size_t i = 0, at = 0, start = 0;
+	int32_t q = 0;
+
+	if (!patauto_compile (o))
+		return 0;
+
+	while (i < len || best != NULL) {
+		if (i < len) {
+			q  = patauto_next (o, q, (unsigned char) s[i++]);
+			st = o->state + q;
+
+			if (best == NULL || i - st->depth <= start) {
+				if ((p = st->out) != NULL &&
+				    (best == NULL || i - p->len < start ||
+				     (i - p->len == start && p->len > best->len)))
+					best = p, start = i - p->len;
+
+				continue;
+			}
+		}
+
+		if (!spans_add (out, s + at, start - at) ||
+		    !spans_add (out, best->value, best->vlen))
+			return 0;
+
+		i = at = start + best->len;
+		q = 0;
+		best = NULL;
+	}
+
+	return spans_add (out, s + at, len - at);
+}
@@ -0,0 +1,53 @@
+/*
+ * Pattern Set Automaton
+ *
+ * Copyright (c) 2025 Alexei A. Smekalkine <ikle@ikle.ru>
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#ifndef PATAUTO_H
+#define PATAUTO_H  1
+
+#include <stdint.h>
+
+#include "patset.h"
+#include "spans.h"
+
+struct patauto_state {
+	int32_t fail;		/* failure state			*/
+	int32_t row;		/* dense transition row or -1		*/
+	uint32_t edge, edges;	/* first sparse transition and count	*/
+	uint32_t depth;		/* length of the state path		*/
+	const struct pattern *out; /* longest pattern ending here	*/
+};
+
+struct patauto {
+	struct patset *P;	/* pattern set				*/
+	unsigned long serial;	/* serial of compiled pattern set	*/
+	int valid;		/* is automaton compiled flag		*/
+
+	size_t count;		/* number of states, root is state 0	*/
+	struct patauto_state *state;
+	unsigned char *label;	/* sparse transitions: labels		*/
+	int32_t *to;		/* and target states			*/
+	int32_t *row;		/* dense transitions, 256 per row	*/
+};
+
+void patauto_init (struct patauto *o, struct patset *P);
+void patauto_fini (struct patauto *o);
+
+/*
+ * patauto_compile builds the Aho-Corasick automaton of the pattern set if
+ * the set has changed since the last compilation.
+ *
+ * patauto_apply replaces the leftmost-longest matches of patterns in the
+ * string s of length len with pattern values and appends the result to
+ * the span list out (see patsub_apply). The automaton is compiled on
+ * demand.
+ */
+int patauto_compile (struct patauto *o);
+int patauto_apply   (struct patauto *o, const char *s, size_t len,
+		     struct spans *out);
+
+#endif  /* PATAUTO_H */
@@ -18,16 +18,94 @@ void patset_init (struct patset *o)
 	o->size   = 0;
 	o->set    = NULL;
 	o->sorted = 0;
+	o->serial = 0;
+	o->slots  = 0;
+	o->index  = NULL;
+
+	arena_init (&o->pool);
 }
 
 void patset_fini (struct patset *o)
 {
+	arena_fini (&o->pool);
+	free (o->index);
+	free (o->set);
+}
+
+/*
+ * Hash index: open addressing with linear probing, at most half full.
+ * Stored hashes reject most of probed patterns without touching names.
+ */
+static uint32_t *patset_slot (const struct patset *o, const char *name,
+			      size_t len, uint32_t hash)
+{
+	const size_t mask = o->slots - 1;
 	size_t i;
+	uint32_t *slot;
+
+	for (i = hash & mask;; i = (i + 1) & mask) {
+		slot = o->index + i;
+
+		if (*slot == 0 || pattern_is (o->set + *slot - 1, name, len, hash))
+			return slot;
+	}
+}
+
+static uint32_t *patset_pslot (const struct patset *o, const struct pattern *p)
+{
+	return patset_slot (o, p->name, p->len, p->hash);
+}
+
+static void patset_reindex (struct patset *o)
+{
+	size_t i;
+
+	memset (o->index, 0, o->slots * sizeof (o->index[0]));
 
 	for (i = 0; i < o->count; ++i)
-		pattern_fini (o->set + i);
+		*patset_pslot (o, o->set + i) = i + 1;
+}
 
-	free (o->set);
+static int patset_rehash (struct patset *o)
+{
+	uint32_t *index;
+	const size_t next = o->slots == 0 ? 16 : o->slots * 2;
+
+	if (next < o->slots || next > (size_t) -1 / sizeof (index[0])) {
+		errno = ENOMEM;  /* size overflow */
+		return 0;
+	}
+
+	if ((index = malloc (next * sizeof (index[0]))) == NULL)
+		return 0;
+
+	free (o->index);
+	o->index = index;
+	o->slots = next;
+
+	patset_reindex (o);
+	return 1;
+}
+
+/*
+ * Removes the slot from the probe sequence: moves back every following
+ * entry of the cluster that may not be found past the hole otherwise
+ */
+static void patset_unslot (struct patset *o, uint32_t *slot)
+{
+	const size_t mask = o->slots - 1;
+	size_t hole = slot - o->index, i, home;
+
+	for (i = (hole + 1) & mask; o->index[i] != 0; i = (i + 1) & mask) {
+		home = o->set[o->index[i] - 1].hash & mask;
+
+		if (((i - home) & mask) >= ((i - hole) & mask)) {
+			o->index[hole] = o->index[i];
+			hole = i;
+		}
+	}
+
+	o->index[hole] = 0;
 }
 
 static int pat_cmp (const void *a, const void *b)
@@ -42,37 +120,42 @@ void patset_sort (struct patset *o)
 	if (o->sorted)
 		return;
 
-	qsort (o->set, o->count, sizeof (o->set[0]), pat_cmp);
+	if (o->count > 1) {
+		qsort (o->set, o->count, sizeof (o->set[0]), pat_cmp);
+		patset_reindex (o);
+	}
+
 	o->sorted = 1;
 }
 
-static int key_cmp (const void *key, const void *b)
+struct pattern *patset_lookup (struct patset *o, const char *name, size_t len)
 {
-	const struct pattern *p = b;
+	uint32_t *slot;
 
-	return strcmp (key, p->name);
+	if (o->count == 0 ||
+	    *(slot = patset_slot (o, name, len, pattern_hash (name, len))) == 0)
+		return NULL;
+
+	return o->set + *slot - 1;
 }
 
 struct pattern *patset_find (struct patset *o, const char *name)
 {
-	patset_sort (o);
-
-	return bsearch (name, o->set, o->count, sizeof (o->set[0]), key_cmp);
+	return patset_lookup (o, name, strlen (name));
 }
 
 static int patset_resize (struct patset *o)
 {
 	struct pattern *p;
-	const size_t next = o->size + 4;
-	const size_t have = o->size * sizeof (p[0]);
-	const size_t need = next    * sizeof (p[0]);
+	const size_t next = o->size == 0 ? 8 : o->size * 2;
 
-	if (need < have) {	/* size overflow */
-		errno = ENOMEM;
+	if (next < o->size || next > (size_t) -1 / sizeof (p[0]) ||
+	    next > UINT32_MAX) {
+		errno = ENOMEM;  /* size overflow */
 		return 0;
 	}
 
-	if ((p = realloc (o->set, need)) == NULL)
+	if ((p = realloc (o->set, next * sizeof (p[0]))) == NULL)
 		return 0;
 
 	o->set  = p;
@@ -82,27 +165,52 @@ static int patset_resize (struct patset *o)
 
 int patset_add (struct patset *o, const char *name, const char *value)
 {
+	struct pattern *p;
+
+	if ((p = patset_find (o, name)) != NULL) {
+		if (!pattern_set_value (p, &o->pool, value))
+			return 0;
+
+		++o->serial;
+		return 1;
+	}
+
 	if (o->count >= o->size && !patset_resize (o))
 		return 0;
 
-	if (!pattern_init (o->set + o->count, name, value))
+	if ((o->count + 1) * 2 > o->slots && !patset_rehash (o))
+		return 0;
+
+	p = o->set + o->count;
+
+	if (!pattern_init (p, &o->pool, name, value))
 		return 0;
 
-	++o->count;
+	*patset_pslot (o, p) = ++o->count;
+
+	++o->serial;
 	o->sorted = 0;
 	return 1;
 }
 
 int patset_del (struct patset *o, const char *name)
 {
-	struct pattern *p;
+	struct pattern *p, *last;
 
 	if ((p = patset_find (o, name)) == NULL)
 		return 0;
 
-	pattern_fini (p);
-	--o->count;
+	last = o->set + o->count - 1;
+
+	patset_unslot (o, patset_pslot (o, p));
 
-	memmove (p, p + 1, ((o->set + o->count) - (p + 1)) * sizeof (p[0]));
+	if (p != last) {
+		*patset_pslot (o, last) = p - o->set + 1;
+		*p = *last;
+		o->sorted = 0;
+	}
+
+	--o->count;
+	++o->serial;
 	return 1;
 }
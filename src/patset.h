@@ -9,21 +9,48 @@
 #ifndef PATSET_H
 #define PATSET_H  1
 
+#include <stdint.h>
+
 #include "pattern.h"
 
 struct patset {
 	size_t count, size;	/* active patterns and available space	*/
 	struct pattern *set;	/* pattern array			*/
 	int sorted;		/* is pattern array sorted flag		*/
+	unsigned long serial;	/* bumped on every change of the set	*/
+
+	size_t slots;		/* hash index size, a power of two	*/
+	uint32_t *index;	/* pattern numbers plus one, 0 if free	*/
+
+	struct arena pool;	/* names and values of patterns		*/
 };
 
 void patset_init (struct patset *o);
 void patset_fini (struct patset *o);
 
+/*
+ * patset_add adds a pattern to the set or replaces the value of the
+ * pattern with the same name.
+ *
+ * patset_del removes the pattern with the specified name from the set,
+ * the last pattern takes its place.
+ *
+ * patset_sort sorts the pattern array by name if it is not sorted yet.
+ * Neither adding nor deleting nor finding patterns keeps the order, thus
+ * sort the set just before walking it in order.
+ */
 int  patset_add  (struct patset *o, const char *name, const char *value);
 int  patset_del  (struct patset *o, const char *name);
 void patset_sort (struct patset *o);
 
-struct pattern *patset_find (struct patset *o, const char *name);
+/*
+ * patset_find looks the pattern up in the hash index, the pointer returned
+ * is valid until the set changes.
+ *
+ * patset_lookup does the same for the name of the specified length, the
+ * name need not be NUL-terminated.
+ */
+struct pattern *patset_find   (struct patset *o, const char *name);
+struct pattern *patset_lookup (struct patset *o, const char *name, size_t len);
 
 #endif  /* PATSET_H*/
@@ -0,0 +1,304 @@
+/*
+ * Multiple Pattern Substitution Test
+ *
+ * Copyright (c) 2025 Alexei A. Smekalkine <ikle@ikle.ru>
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "patauto.h"
+#include "patsub.h"
+
+static const char *S;
+
+static int ref_cmp (const void *a, const void *b)
+{
+	const int32_t *l = a, *r = b;
+
+	return strcmp (S + *l, S + *r);
+}
+
+/*
+ * Checks the suffix array built by patsub_mark against qsort of suffixes
+ */
+static int check (struct patsub *o, const char *s)
+{
+	const size_t n = strlen (s);
+	int32_t *ref;
+	size_t i;
+	int ok;
+
+	if (!patsub_mark (o, s) || (ref = malloc (n * sizeof (ref[0]))) == NULL)
+		return 0;
+
+	for (i = 0; i < n; ++i)
+		ref[i] = i;
+
+	S = s;
+	qsort (ref, n, sizeof (ref[0]), ref_cmp);
+
+	ok = o->SA[0] == n && memcmp (o->SA + 1, ref, n * sizeof (ref[0])) == 0;
+	free (ref);
+	return ok;
+}
+
+/*
+ * Checks marks against the longest pattern starting at every position
+ */
+static int check_marks (struct patsub *o, const char *s)
+{
+	const struct pattern *best, *m;
+	size_t i, j;
+
+	for (i = 0; s[i] != '\0'; ++i) {
+		for (j = 0, best = NULL; j < o->P->count; ++j)
+			if (strncmp (o->P->set[j].name, s + i, o->P->set[j].len) == 0 &&
+			    (best == NULL || o->P->set[j].len > best->len))
+				best = o->P->set + j;
+
+		if ((m = patsub_match (o, i)) != best &&
+		    (m == NULL || best == NULL || strcmp (m->name, best->name) != 0))
+			return 0;
+	}
+
+	return 1;
+}
+
+/*
+ * Checks that the automaton replaces the same matches as the marks do
+ */
+static int check_auto (struct patsub *o, struct patauto *a, const char *s)
+{
+	const struct pattern *m;
+	struct spans out;
+	struct blob ref, res;
+	size_t i, n;
+	int ok;
+
+	spans_init (&out);
+	blob_init (&ref);
+	blob_init (&res);
+
+	for (i = 0, ok = 1; ok && s[i] != '\0'; i += n)
+		if ((m = patsub_match (o, i)) == NULL)
+			ok = blob_write (&ref, s + i, n = 1);
+		else
+			ok = blob_write (&ref, m->value, strlen (m->value)),
+			n = m->len;
+
+	ok = ok && patsub_apply (o, s) && spans_gather (&o->out, &res) &&
+	     ref.count == res.count &&
+	     memcmp (ref.data, res.data, ref.count) == 0;
+
+	res.count = 0;
+
+	ok = ok && patauto_apply (a, s, strlen (s), &out) &&
+	     spans_gather (&out, &res) && ref.count == res.count &&
+	     memcmp (ref.data, res.data, ref.count) == 0;
+
+	blob_fini (&res);
+	blob_fini (&ref);
+	spans_fini (&out);
+	return ok;
+}
+
+/*
+ * Test lines: a CUPL-style list, a single repeated character and random
+ * text over a small alphabet
+ */
+static char *make_line (int kind, size_t len)
+{
+	char *s, item[16];
+	size_t i, n;
+
+	if ((s = malloc (len + 16)) == NULL)
+		return NULL;
+
+	for (i = 0; i < len; i += n)
+		switch (kind) {
+		case 0:
+			n = snprintf (item, sizeof (item), i == 0 ? "[Q%zu" :
+				      ", Q%zu", i / 4 % 16);
+			memcpy (s + i, item, n);
+			break;
+		case 1:
+			s[i] = 'a', n = 1;
+			break;
+		default:
+			s[i] = "ab[]Q0, "[rand () % 8], n = 1;
+		}
+
+	s[len] = '\0';
+	return s;
+}
+
+static const char *kinds[] = { "list", "repeat", "random" };
+
+/*
+ * Long patterns share prefixes longer than the saturation value of Llcp
+ * and Rlcp: lines of long runs of 'a' force the search to resume the
+ * comparison past it
+ */
+static char *make_run (size_t run, const char *tail)
+{
+	char *s;
+
+	if ((s = malloc (run + strlen (tail) + 1)) == NULL)
+		return NULL;
+
+	memset (s, 'a', run);
+	strcpy (s + run, tail);
+	return s;
+}
+
+static int check_long (void)
+{
+	static const struct { size_t run; const char *tail; } set[] = {
+		{ 300, "b" }, { 300, "c" }, { 299, "d" }, { 255, "b" },
+		{ 256, "" }, { 400, "" }, { 300, "bc" },
+	};
+	struct patset P;
+	struct patsub o;
+	struct patauto a;
+	size_t i, len, run;
+	char *s, *p;
+	int ok = 1;
+
+	patset_init (&P);
+
+	for (i = 0; ok && i < sizeof (set) / sizeof (set[0]); ++i)
+		if ((p = make_run (set[i].run, set[i].tail)) == NULL)
+			ok = 0;
+		else {
+			ok = patset_add (&P, p, set[i].tail);
+			free (p);
+		}
+
+	patsub_init (&o, &P);
+	patauto_init (&a, &P);
+
+	for (i = 0; ok && i < 32; ++i) {
+		if ((s = malloc (8192)) == NULL) {
+			ok = 0;
+			break;
+		}
+
+		for (len = 0; len < 8192 - 512; len += run + 1) {
+			run = 200 + rand () % 250;
+			memset (s + len, 'a', run);
+			s[len + run] = "bcd"[rand () % 3];
+		}
+
+		s[len] = '\0';
+
+		if (!check (&o, s) || !check_marks (&o, s) ||
+		    !check_auto (&o, &a, s)) {
+			fprintf (stderr, "E: long, %zu: wrong marks\n", len);
+			ok = 0;
+		}
+
+		free (s);
+	}
+
+	patauto_fini (&a);
+	patsub_fini (&o);
+	patset_fini (&P);
+	return ok;
+}
+
+static uint64_t now (void)
+{
+	struct timespec ts;
+
+	clock_gettime (CLOCK_MONOTONIC, &ts);
+	return (uint64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+int main (int argc, char *argv[])
+{
+	struct patset P;
+	struct patsub o;
+	struct patauto a;
+	struct spans out;
+	size_t k, len, iters, i;
+	uint64_t t, ta;
+	char *s;
+	int ok = 1;
+
+	patset_init (&P);
+
+	if (!patset_add (&P, "Q0", "A0") || !patset_add (&P, "Q1", "A1") ||
+	    !patset_add (&P, "Q15", "A15") || !patset_add (&P, "Q", "B") ||
+	    !patset_add (&P, "aa", "A") || !patset_add (&P, "aaa", "AA") ||
+	    !patset_add (&P, ", Q1", "C") || !patset_add (&P, "b[", "D") ||
+	    !patset_add (&P, "]", "E")) {
+		perror ("patsub-test");
+		return 1;
+	}
+
+	patsub_init (&o, &P);
+	patauto_init (&a, &P);
+	spans_init (&out);
+
+	for (k = 0; k < 3; ++k)
+		for (len = 0; len < 300; ++len) {
+			if ((s = make_line (k, len)) == NULL || !check (&o, s)) {
+				fprintf (stderr, "E: %s, %zu: wrong suffix array\n",
+					 kinds[k], len);
+				ok = 0;
+			}
+			else if (!check_marks (&o, s)) {
+				fprintf (stderr, "E: %s, %zu: wrong marks\n",
+					 kinds[k], len);
+				ok = 0;
+			}
+			else if (!check_auto (&o, &a, s)) {
+				fprintf (stderr, "E: %s, %zu: wrong substitution\n",
+					 kinds[k], len);
+				ok = 0;
+			}
+
+			free (s);
+		}
+
+	ok &= check_long ();
+
+	printf ("line,bytes,iters,mark_ns_per_byte,auto_ns_per_byte\n");
+
+	for (k = 0; k < 3; ++k)
+		for (len = 1024; len <= 1024 * 1024; len *= 4) {
+			if ((s = make_line (k, len)) == NULL)
+				break;
+
+			iters = 4 * 1024 * 1024 / len;
+			t = now ();
+
+			for (i = 0; i < iters; ++i)
+				ok &= patsub_mark (&o, s);
+
+			t = now () - t;
+			ta = now ();
+
+			for (i = 0; i < iters; ++i) {
+				spans_reset (&out);
+				ok &= patauto_apply (&a, s, len, &out);
+			}
+
+			ta = now () - ta;
+			printf ("%s,%zu,%zu,%.2f,%.2f\n", kinds[k], len, iters,
+				(double) t / iters / len,
+				(double) ta / iters / len);
+			free (s);
+		}
+
+	spans_fini (&out);
+	patauto_fini (&a);
+	patsub_fini (&o);
+	patset_fini (&P);
+	return ok ? 0 : 1;
+}
@@ -10,28 +10,35 @@
 #include <stdlib.h>
 #include <string.h>
 
-#include "patset.h"
+#include "patsub.h"
+#include "sais.h"
 
-struct patsub {
-	struct patset *P;	/* pattern set				*/
-
-	size_t N, space;	/* source string length and space	*/
-	const char **SA;	/* sorted array of non-empty suffixes	*/
-	const struct pattern **M; /* pattern marks for source positions	*/
+struct patsub_frame {
+	int32_t p;			/* index of matched pattern	*/
+	size_t hi;			/* end of suffix range		*/
 };
 
 void patsub_init (struct patsub *o, struct patset *P)
 {
 	o->P      = P;
+	o->S      = NULL;
 	o->N      = 0;
 	o->space  = 0;
 	o->SA     = NULL;
+	o->LCP    = NULL;
+	o->Llcp   = NULL;
+	o->Rlcp   = NULL;
 	o->M      = NULL;
+	o->depth  = 0;
+	o->stack  = NULL;
+
+	spans_init (&o->out);
 }
 
 void patsub_fini (struct patsub *o)
 {
-	free (o->M);
+	spans_fini (&o->out);
+	free (o->stack);
 	free (o->SA);
 }
 
@@ -39,142 +46,298 @@ void patsub_fini (struct patsub *o)
  * 3. Mark string positions with matched patterns
  */
 
+/*
+ * Working arrays live in one block: the suffix array of N + 1 items and
+ * the LCP array of N 32-bit items, the latter turns into the marks array
+ * once the search tree is built, then the Llcp and Rlcp arrays of N bytes
+ * each. That is 10 bytes per source byte: the suffix array alone takes 4,
+ * thus 4 bytes per source byte is out of reach with 32-bit offsets. The
+ * space after the suffix array is the sais scratch space while sorting,
+ * it is enlarged for short strings only.
+ */
+#define PATSUB_LCP_MAX	255	/* Llcp and Rlcp saturate at this value	*/
+
 static int patsub_resize (struct patsub *o)
 {
-	const char **SA;
-	const struct pattern **M;  /* W: sizeof M[0] == sizeof SA[0] */
+	const size_t item = 2 * sizeof (o->SA[0]) + 2;
+	size_t next = o->space == 0 ? 64 : o->space * 2, tail;
+	int32_t *SA;
 
-	const size_t next = o->N;
-	const size_t have = o->space * sizeof (SA[0]);
-	const size_t need = next     * sizeof (SA[0]);
+	if (next < o->N)
+		next = o->N;
 
-	if (need < have) {	/* size overflow */
+	if (next > ((size_t) -1 - 2048) / item) {		/* size overflow */
 		errno = ENOMEM;
 		return 0;
 	}
 
-	if ((SA = realloc (o->SA, need)) == NULL)
-		return 0;
+	tail = next * (item - sizeof (SA[0]));
 
-	o->SA = SA;
+	if (tail < sais_work_size (next))
+		tail = sais_work_size (next);
 
-	if ((M = realloc (o->M, need)) == NULL)
+	if ((SA = realloc (o->SA, (next + 1) * sizeof (SA[0]) + tail)) == NULL)
 		return 0;
 
-	o->M = M;
+	o->SA    = SA;
+	o->LCP   = SA + next + 1;
+	o->M     = o->LCP;
+	o->Llcp  = (uint8_t *) (o->LCP + next);
+	o->Rlcp  = o->Llcp + next;
 	o->space = next;
 	return 1;
 }
 
-static int cmp (const struct patsub *o, size_t p, size_t s)
+/* returns non-empty suffix number s in the sorted order */
+static inline const char *suffix (const struct patsub *o, size_t s)
 {
-	const struct pattern *P = o->P->set + p;
-
-	return strncmp (P->name, o->SA[s], P->len);
+	return o->S + o->SA[s + 1];
 }
 
-static size_t find_any_pair (const struct patsub *o, size_t p, size_t s)
+/*
+ * Karkkainen et al., the Phi method: LCP[i] is the length of the longest
+ * common prefix of the suffix at position i and the suffix preceding it
+ * in the sorted order. LCP first holds positions of preceding suffixes,
+ * every one of them is read once just before it is replaced, thus no
+ * rank array is needed.
+ */
+static void patsub_lcp (struct patsub *o)
 {
-	/* to do: binary search */
+	const char *S = o->S;
+	int32_t *phi = o->LCP;
+	size_t i, h, s;
+	int32_t j;
+
+	for (s = 0; s < o->N; ++s)
+		phi[o->SA[s + 1]] = s == 0 ? -1 : o->SA[s];
+
+	for (i = 0, h = 0; i < o->N; ++i) {
+		if ((j = phi[i]) < 0) {
+			phi[i] = h = 0;
+			continue;
+		}
+
+		for (; S[i + h] != '\0' && S[i + h] == S[j + h]; ++h) {}
 
-	for (; p < o->P->count; ++p)
-		if (cmp (o, p, s) == 0)
-			return p;
+		phi[i] = h;
+
+		if (h > 0)
+			--h;
+	}
+}
 
-	return -1;
+static inline uint8_t lcp_sat (int32_t h)
+{
+	return h < PATSUB_LCP_MAX ? h : PATSUB_LCP_MAX;
 }
 
-static size_t find_first_suffix (const struct patsub *o, size_t p, size_t s)
+/*
+ * Manber and Myers: for every middle node M of the binary search over the
+ * range (L, R) store LCP of suffixes L and M into Llcp[M] and LCP of
+ * suffixes M and R into Rlcp[M], saturated. The bounds -1 and N are
+ * virtual suffixes with no common prefix.
+ */
+static int32_t patsub_lcp_lr (struct patsub *o, ptrdiff_t L, ptrdiff_t R)
 {
-	/* to do: binary search */
+	ptrdiff_t M;
+	int32_t l, r;
 
-	for (; s < o->N; ++s)
-		if (cmp (o, p, s) == 0)
-			return s;
+	if (R - L == 1)
+		return L < 0 || R >= o->N ? 0 : o->LCP[o->SA[R + 1]];
 
-	return -1;
+	M = L + (R - L) / 2;
+	l = patsub_lcp_lr (o, L, M);
+	r = patsub_lcp_lr (o, M, R);
+
+	o->Llcp[M] = lcp_sat (l);
+	o->Rlcp[M] = lcp_sat (r);
+	return l < r ? l : r;
 }
 
-static int str_cmp (const void *L, const void *R)
+static size_t match (const char *a, const char *b)
 {
-	const char *const *pl = L;
-	const char *const *pr = R;
+	size_t i;
+
+	for (i = 0; a[i] != '\0' && a[i] == b[i]; ++i) {}
 
-	return strcmp (*pl, *pr);
+	return i;
 }
 
-static int patsub_mark (struct patsub *o, const char *S)
+/*
+ * Returns the first suffix that starts with pattern or follows it (upper
+ * is zero), or the first suffix that follows all suffixes starting with
+ * pattern (upper is non-zero). The LCP of pattern and a range bound is
+ * known during the search, thus every node is either resolved by the Llcp
+ * or Rlcp of it or compared starting from the known LCP, and no character
+ * of pattern is compared twice with matching result. A saturated Llcp or
+ * Rlcp only tells that the LCP is at least that long: then the node is
+ * compared starting from the saturation value.
+ */
+static size_t patsub_find (const struct patsub *o, const struct pattern *p,
+			   int upper)
 {
-	size_t i, p = 0, s = 0;
-	int a;
+	ptrdiff_t L = -1, R = o->N, M;
+	size_t l = 0, r = 0, m, h;
+	const char *s;
+
+	while (R - L > 1) {
+		M = L + (R - L) / 2;
+		m = l >= r ? l : r;
+		h = l >= r ? o->Llcp[M] : o->Rlcp[M];
+
+		if (h == PATSUB_LCP_MAX && m >= h)
+			m = h;
+		else if (h != m && l >= r) {
+			if (h > l)
+				L = M;
+			else
+				R = M, r = h;
+
+			continue;
+		}
+		else if (h != m) {
+			if (h > r)
+				R = M;
+			else
+				L = M, l = h;
 
-	o->N = strlen (S);			/* to do: resize SA & M	*/
+			continue;
+		}
 
-	if (o->N > o->space && !patsub_resize (o))
-		return 0;
+		s = suffix (o, M);
+		m += match (p->name + m, s + m);
 
-	for (i = 0; i < o->N; ++i) {
-		o->SA[i] = S + i;		/* init suffixes	*/
-		o->M[i]  = NULL;		/* init marks		*/
+		if (m == p->len ? !upper : (unsigned char) p->name[m] <
+					   (unsigned char) s[m])
+			R = M, r = m;
+		else
+			L = M, l = m;
 	}
 
-	patset_sort (o->P);
-	qsort (o->SA, o->N, sizeof (o->SA[0]), str_cmp);
-
-	for (; s < o->N; ++s) {
-		if ((a = cmp (o, p, s)) < 0) {		/* find next p	*/
-			if ((p = find_any_pair (o, p + 1, s)) == -1)
-				return 1;
-		}
-		else if (a > 0) {			/* find next s	*/
-			if ((s = find_first_suffix (o, p, s + 1)) == -1)
-				return 1;
-		}
+	return R;
+}
 
-		/* P[p] matches SA[s] now, find longest match */
+static int patsub_push (struct patsub *o, size_t *depth, int32_t p, size_t hi)
+{
+	const size_t next = o->depth * 2 + 4;
+	struct patsub_frame *stack;
 
-		while ((p + 1) < o->P->count && cmp (o, p + 1, s) == 0)  ++p;
+	if (*depth >= o->depth) {
+		if ((stack = realloc (o->stack, next * sizeof (stack[0]))) == NULL)
+			return 0;
 
-		o->M[o->SA[s] - S] = o->P->set + p;  /* mark pos. with a match */
+		o->stack = stack;
+		o->depth = next;
 	}
 
+	o->stack[*depth].p  = p;
+	o->stack[*depth].hi = hi;
+	++*depth;
 	return 1;
 }
 
 /*
- * 4. Apply patterns to source string
+ * Marks suffixes starting from s up to the end suffix with the innermost
+ * (longest) pattern that covers them
  */
-
-static int emit_char (struct patsub *o, int a)
+static size_t patsub_paint (struct patsub *o, size_t *depth, size_t s,
+			    size_t end)
 {
-	return 0;  /* not implemented */
+	struct patsub_frame *f;
+	size_t to;
+
+	while (s < end && *depth > 0) {
+		f = o->stack + *depth - 1;
+
+		if (f->hi <= s) {
+			--*depth;
+			continue;
+		}
+
+		for (to = f->hi < end ? f->hi : end; s < to; ++s)
+			o->M[o->SA[s + 1]] = f->p;
+	}
+
+	return end;
 }
 
-static int emit_string (struct patsub *o, const char *s)
+/*
+ * Suffixes starting with a pattern form a range of the suffix array. For
+ * the sorted pattern set these ranges follow in order, and the range of a
+ * pattern nests into the range of every pattern that is its prefix. Thus
+ * one pass over ranges with a stack of open ones marks every position with
+ * the longest pattern.
+ */
+int patsub_mark (struct patsub *o, const char *S)
 {
-	return 0;  /* not implemented */
+	size_t i, lo, hi, s = 0, depth = 0;
+	const struct pattern *p;
+
+	o->S = S;
+	o->N = strlen (S);
+
+	if ((o->N > o->space || o->SA == NULL) && !patsub_resize (o))
+		return 0;
+
+	patset_sort (o->P);
+
+	if (o->P->count > INT32_MAX) {
+		errno = EOVERFLOW;
+		return 0;
+	}
+
+	if (!sais (S, o->N, o->SA, o->LCP))	/* sort suffixes	*/
+		return 0;
+
+	if (o->P->count > 0 && o->N > 0) {
+		patsub_lcp (o);
+		patsub_lcp_lr (o, -1, o->N);
+	}
+
+	for (i = 0; i < o->N; ++i)
+		o->M[i] = -1;			/* init marks over LCP	*/
+
+	for (i = 0; i < o->P->count; ++i) {
+		p = o->P->set + i;
+
+		if (p->len == 0 || (lo = patsub_find (o, p, 0)) >= o->N ||
+		    (hi = patsub_find (o, p, 1)) <= lo)
+			continue;
+
+		s = patsub_paint (o, &depth, s, lo);
+
+		if (!patsub_push (o, &depth, i, hi))
+			return 0;
+	}
+
+	patsub_paint (o, &depth, s, o->N);
+	return 1;
 }
 
+/*
+ * 4. Apply patterns to source string
+ */
+
 int patsub_apply (struct patsub *o, const char *S)
 {
-	size_t i, n;
+	const struct pattern *p;
+	size_t i, at;
 
 	if (!patsub_mark (o, S))
 		return 0;
 
-	for (i = 0; i < o->N; i += n)
-		if (o->M[i] == NULL) {
-			if (!emit_char (o, S[i]))
-				return 0;
+	spans_reset (&o->out);
 
-			n = 1;
-		}
+	for (i = 0, at = 0; i < o->N; )
+		if ((p = patsub_match (o, i)) == NULL)
+			++i;
 		else {
-			if (!emit_string (o, o->M[i]->value))
+			if (!spans_add (&o->out, S + at, i - at) ||
+			    !spans_add (&o->out, p->value, p->vlen))
 				return 0;
 
-			n = o->M[i]->len;
+			at = i += p->len;
 		}
 
-	return 1;
+	return spans_add (&o->out, S + at, o->N - at);
 }
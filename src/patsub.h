@@ -0,0 +1,60 @@
+/*
+ * Multiple Pattern Substitution
+ *
+ * Copyright (c) 2022-2025 Alexei A. Smekalkine <ikle@ikle.ru>
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#ifndef PATSUB_H
+#define PATSUB_H  1
+
+#include <stdint.h>
+
+#include "patset.h"
+#include "spans.h"
+
+struct patsub {
+	struct patset *P;	/* pattern set				*/
+	const char *S;		/* source string			*/
+
+	size_t N, space;	/* source string length and space	*/
+	int32_t *SA;		/* suffix array, see sais		*/
+	int32_t *LCP;		/* LCP with the preceding suffix, by position */
+	uint8_t *Llcp, *Rlcp;	/* LCP of search node with its bounds, saturated */
+	int32_t *M;		/* marks: pattern indices or -1, over LCP */
+
+	size_t depth;		/* space for nested pattern matches	*/
+	struct patsub_frame *stack;
+
+	struct spans out;	/* result of the last substitution	*/
+};
+
+void patsub_init (struct patsub *o, struct patset *P);
+void patsub_fini (struct patsub *o);
+
+/*
+ * patsub_mark builds the suffix and LCP arrays of the source string and
+ * marks every source position with the index of the longest pattern that
+ * starts there in the sorted pattern set, or with -1 if there is no such
+ * pattern. Marks are valid while the pattern set is intact.
+ */
+int patsub_mark  (struct patsub *o, const char *S);
+
+/* returns the pattern marked at source position i or NULL */
+static inline
+const struct pattern *patsub_match (const struct patsub *o, size_t i)
+{
+	return o->M[i] < 0 ? NULL : o->P->set + o->M[i];
+}
+
+/*
+ * patsub_apply replaces the marked matches with pattern values and stores
+ * the result into the out span list: unchanged runs of the source string
+ * and pattern values are referenced, not copied. Thus the result is valid
+ * while the source string and the pattern set are intact, and a string
+ * without matches is the only span referring to the source string.
+ */
+int patsub_apply (struct patsub *o, const char *S);
+
+#endif  /* PATSUB_H */
@@ -6,30 +6,75 @@
  * SPDX-License-Identifier: BSD-2-Clause
  */
 
-#include <stdlib.h>
+#include <errno.h>
 #include <string.h>
 
 #include "pattern.h"
 
-int pattern_init (struct pattern *o, const char *name, const char *value)
+uint32_t pattern_hash (const char *name, size_t len)
 {
-	o->len = strlen (name);
+	uint64_t h = 0xcbf29ce484222325;	/* FNV-1a	*/
+	size_t i;
 
-	if ((o->name = strdup (name)) == NULL)
-		return 0;
+	for (i = 0; i < len; ++i)
+		h = (h ^ (unsigned char) name[i]) * 0x100000001b3;
 
-	if ((o->value = strdup (value)) != NULL)
-		goto no_value;
+	return h ^ h >> 32;
+}
 
-	return 1;
-no_value:
-	free (o->name);
-	return 0;
+static char *pool_copy (struct arena *pool, const char *a, size_t alen,
+			const char *b, size_t blen)
+{
+	char *p;
+
+	if (alen + blen < alen || alen + blen + 2 < 2) {  /* size overflow */
+		errno = ENOMEM;
+		return NULL;
+	}
+
+	if ((p = arena_alloc_bytes (pool, alen + blen + 2)) == NULL)
+		return NULL;
+
+	memcpy (p, a, alen);
+	p[alen] = '\0';
+	memcpy (p + alen + 1, b, blen);
+	p[alen + 1 + blen] = '\0';
+	return p;
 }
 
-void pattern_fini (struct pattern *o)
+int pattern_init (struct pattern *o, struct arena *pool,
+		  const char *name, const char *value)
 {
-	free (o->value);
-	free (o->name);
+	char *p;
+
+	o->len  = strlen (name);
+	o->vlen = strlen (value);
+	o->hash = pattern_hash (name, o->len);
+
+	if ((p = pool_copy (pool, name, o->len, value, o->vlen)) == NULL)
+		return 0;
+
+	o->name  = p;
+	o->value = p + o->len + 1;
+	return 1;
 }
 
+int pattern_set_value (struct pattern *o, struct arena *pool,
+		       const char *value)
+{
+	const size_t vlen = strlen (value);
+	char *p;
+
+	if (vlen <= o->vlen) {			/* fits in place	*/
+		memcpy ((char *) o->value, value, vlen + 1);
+		o->vlen = vlen;
+		return 1;
+	}
+
+	if ((p = pool_copy (pool, value, vlen, "", 0)) == NULL)
+		return 0;
+
+	o->value = p;
+	o->vlen  = vlen;
+	return 1;
+}
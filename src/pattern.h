@@ -10,13 +10,38 @@
 #define PATTERN_H  1
 
 #include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "arena.h"
 
 struct pattern {
-	size_t len;
-	char *name, *value;
+	size_t len, vlen;	/* name and value lengths		*/
+	uint32_t hash;		/* hash of name, see pattern_hash	*/
+	const char *name, *value;
 };
 
-int  pattern_init (struct pattern *o, const char *name, const char *value);
-void pattern_fini (struct pattern *o);
+/*
+ * pattern_init copies the name and the value into one block allocated from
+ * the pool, the pattern needs no finalization: the strings are released
+ * with the pool.
+ *
+ * pattern_set_value copies the new value into the pool, the old value is
+ * kept until the pool is released.
+ */
+int pattern_init (struct pattern *o, struct arena *pool,
+		  const char *name, const char *value);
+int pattern_set_value (struct pattern *o, struct arena *pool,
+		       const char *value);
+
+uint32_t pattern_hash (const char *name, size_t len);
+
+/* returns non-zero if the pattern has the specified name and its hash */
+static inline int pattern_is (const struct pattern *o, const char *name,
+			      size_t len, uint32_t hash)
+{
+	return o->hash == hash && o->len == len &&
+	       memcmp (o->name, name, len) == 0;
+}
 
 #endif  /* PATTERN_H */
@@ -0,0 +1,173 @@
+/*
+ * Work-Stealing Thread Pool
+ *
+ * Copyright (c) 2025 Alexei A. Smekalkine <ikle@ikle.ru>
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <stdlib.h>
+
+#include <pthread.h>
+#include <unistd.h>
+
+#include "pool.h"
+
+struct pool_share {
+	pthread_mutex_t lock;
+	size_t head, tail;		/* items left: [head, tail)	*/
+};
+
+struct pool_worker {
+	struct pool *pool;
+	unsigned id;
+	pthread_t thread;
+	int ok;
+};
+
+struct pool {
+	pool_fn *fn;
+	void *cookie;
+
+	unsigned count;
+	struct pool_share  *share;
+	struct pool_worker *worker;
+};
+
+static int pool_take (struct pool_share *s, size_t *i)
+{
+	int ok;
+
+	pthread_mutex_lock (&s->lock);
+
+	if ((ok = s->head < s->tail))
+		*i = s->head++;
+
+	pthread_mutex_unlock (&s->lock);
+	return ok;
+}
+
+static int pool_steal (struct pool *o, unsigned id)
+{
+	struct pool_share *own = o->share + id, *s;
+	size_t left, best = 0, head, tail;
+	unsigned i, victim = id;
+
+	for (i = 0; i < o->count; ++i) {	/* find largest share	*/
+		s = o->share + i;
+
+		pthread_mutex_lock (&s->lock);
+		left = s->tail - s->head;
+		pthread_mutex_unlock (&s->lock);
+
+		if (left > best) {
+			best   = left;
+			victim = i;
+		}
+	}
+
+	if (victim == id)
+		return 0;
+
+	s = o->share + victim;
+	pthread_mutex_lock (&s->lock);
+
+	if (s->head >= s->tail) {		/* lost the race	*/
+		pthread_mutex_unlock (&s->lock);
+		return 1;
+	}
+
+	tail = s->tail;
+	head = s->tail = s->head + (tail - s->head) / 2;
+	pthread_mutex_unlock (&s->lock);
+
+	pthread_mutex_lock (&own->lock);
+	own->head = head;
+	own->tail = tail;
+	pthread_mutex_unlock (&own->lock);
+	return 1;
+}
+
+static void *pool_worker (void *cookie)
+{
+	struct pool_worker *w = cookie;
+	struct pool *o = w->pool;
+	size_t i;
+
+	do {
+		while (pool_take (o->share + w->id, &i))
+			w->ok &= o->fn (o->cookie, w->id, i);
+	}
+	while (pool_steal (o, w->id));
+
+	return NULL;
+}
+
+unsigned pool_threads (unsigned threads)
+{
+	long n;
+
+	if (threads > 0)
+		return threads;
+
+	n = sysconf (_SC_NPROCESSORS_ONLN);
+	return n > 0 ? n : 1;
+}
+
+int pool_run (size_t count, unsigned threads, pool_fn *fn, void *cookie)
+{
+	struct pool o = { fn, cookie };
+	unsigned i, started;
+	size_t j;
+	int ok = 1;
+
+	o.count = pool_threads (threads);
+
+	if (o.count > count)
+		o.count = count > 0 ? count : 1;
+
+	o.share  = calloc (o.count, sizeof (o.share[0]));
+	o.worker = calloc (o.count, sizeof (o.worker[0]));
+
+	if (o.share == NULL || o.worker == NULL)
+		goto no_mem;
+
+	for (i = 0; i < o.count; ++i) {
+		pthread_mutex_init (&o.share[i].lock, NULL);
+		o.share[i].head = count * i / o.count;
+		o.share[i].tail = count * (i + 1) / o.count;
+
+		o.worker[i].pool = &o;
+		o.worker[i].id   = i;
+		o.worker[i].ok   = 1;
+	}
+
+	/* worker zero runs on the calling thread */
+
+	for (started = 1; started < o.count; ++started)
+		if (pthread_create (&o.worker[started].thread, NULL,
+				    pool_worker, o.worker + started) != 0)
+			break;
+
+	pool_worker (o.worker);
+
+	for (i = 1; i < started; ++i)
+		pthread_join (o.worker[i].thread, NULL);
+
+	for (i = 0; i < o.count; ++i) {
+		ok &= o.worker[i].ok;
+		pthread_mutex_destroy (&o.share[i].lock);
+	}
+
+	free (o.worker);
+	free (o.share);
+	return ok;
+no_mem:					/* no pool: run items in order */
+	free (o.worker);
+	free (o.share);
+
+	for (j = 0; j < count; ++j)
+		ok &= fn (cookie, 0, j);
+
+	return ok;
+}
@@ -0,0 +1,36 @@
+/*
+ * Work-Stealing Thread Pool
+ *
+ * Copyright (c) 2025 Alexei A. Smekalkine <ikle@ikle.ru>
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#ifndef POOL_H
+#define POOL_H  1
+
+#include <stddef.h>
+
+/*
+ * Job callback: processes item i on the specified worker, workers are
+ * numbered from zero. Returns zero on failure.
+ */
+typedef int pool_fn (void *cookie, unsigned worker, size_t i);
+
+/*
+ * pool_threads returns the number of worker threads to use for the
+ * requested number: zero selects the number of online CPUs.
+ *
+ * pool_run calls fn for all items from zero to count - 1 on the specified
+ * number of worker threads (see pool_threads) and waits for completion.
+ * Every worker starts with an equal contiguous share of items and, when
+ * its share is exhausted, steals the upper half of the largest remaining
+ * share of another worker. If the pool cannot be set up, then all the
+ * items are processed in order on the calling thread as worker zero.
+ * Returns zero if fn failed for any item, all the items are processed
+ * anyway.
+ */
+unsigned pool_threads (unsigned threads);
+int pool_run (size_t count, unsigned threads, pool_fn *fn, void *cookie);
+
+#endif  /* POOL_H */
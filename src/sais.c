@@ -0,0 +1,226 @@
+/*
+ * Linear Time Suffix Array Construction
+ *
+ * Copyright (c) 2025 Alexei A. Smekalkine <ikle@ikle.ru>
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sais.h"
+
+/*
+ * The input string is either a string of bytes (on the top level) or a
+ * string of 32-bit names (on recursion levels), the last symbol is the
+ * unique smallest sentinel.
+ */
+struct sais {
+	const void *s;
+	int wide;		/* 32-bit symbols, bytes otherwise	*/
+	int32_t n, k;		/* string length and alphabet size	*/
+	unsigned char *t;	/* suffix types: S (1) or L (0)		*/
+	int32_t *bkt;		/* bucket heads or tails		*/
+};
+
+static inline int32_t chr (const struct sais *o, int32_t i)
+{
+	return o->wide ? ((const int32_t *) o->s)[i] :
+			 ((const unsigned char *) o->s)[i];
+}
+
+static inline int tget (const struct sais *o, int32_t i)
+{
+	return o->t[i / 8] >> (i % 8) & 1;
+}
+
+static inline void tset (struct sais *o, int32_t i, int b)
+{
+	if (b)
+		o->t[i / 8] |=  1u << (i % 8);
+	else
+		o->t[i / 8] &= ~(1u << (i % 8));
+}
+
+static inline int is_lms (const struct sais *o, int32_t i)
+{
+	return i > 0 && tget (o, i) && !tget (o, i - 1);
+}
+
+static void get_buckets (struct sais *o, int end)
+{
+	int32_t i, sum = 0;
+
+	memset (o->bkt, 0, o->k * sizeof (o->bkt[0]));
+
+	for (i = 0; i < o->n; ++i)
+		++o->bkt[chr (o, i)];
+
+	for (i = 0; i < o->k; ++i) {
+		sum += o->bkt[i];
+		o->bkt[i] = end ? sum : sum - o->bkt[i];
+	}
+}
+
+static void induce (struct sais *o, int32_t *SA)
+{
+	int32_t i, j;
+
+	get_buckets (o, 0);			/* L-type suffixes	*/
+
+	for (i = 0; i < o->n; ++i)
+		if ((j = SA[i] - 1) >= 0 && !tget (o, j))
+			SA[o->bkt[chr (o, j)]++] = j;
+
+	get_buckets (o, 1);			/* S-type suffixes	*/
+
+	for (i = o->n - 1; i >= 0; --i)
+		if ((j = SA[i] - 1) >= 0 && tget (o, j))
+			SA[--o->bkt[chr (o, j)]] = j;
+}
+
+static int lms_equal (const struct sais *o, int32_t a, int32_t b)
+{
+	int32_t d;
+
+	for (d = 0; d < o->n; ++d) {
+		if (chr (o, a + d) != chr (o, b + d) ||
+		    tget (o, a + d) != tget (o, b + d))
+			return 0;
+
+		if (d > 0 && (is_lms (o, a + d) || is_lms (o, b + d)))
+			return 1;
+	}
+
+	return 0;
+}
+
+/*
+ * Every level takes its bucket array and type bits from the scratch space
+ * and passes the rest of it to the next level: the string is at least
+ * twice shorter there and the alphabet is not larger than the string.
+ */
+static void sais_run (const void *s, int wide, int32_t n, int32_t k,
+		      int32_t *SA, int32_t *bkt, unsigned char *t)
+{
+	struct sais o = { s, wide, n, k, t, bkt };
+	int32_t i, j, n1, name, prev, pos, *s1;
+
+	/* classify suffixes, the sentinel is S-type */
+
+	tset (&o, n - 1, 1);
+
+	if (n > 1)
+		tset (&o, n - 2, 0);
+
+	for (i = n - 3; i >= 0; --i)
+		tset (&o, i, chr (&o, i) < chr (&o, i + 1) ||
+			     (chr (&o, i) == chr (&o, i + 1) && tget (&o, i + 1)));
+
+	/* stage 1: sort LMS substrings */
+
+	get_buckets (&o, 1);
+
+	for (i = 0; i < n; ++i)
+		SA[i] = -1;
+
+	for (i = 1; i < n; ++i)
+		if (is_lms (&o, i))
+			SA[--o.bkt[chr (&o, i)]] = i;
+
+	induce (&o, SA);
+
+	/* compact sorted LMS substrings into the first n1 items and name them */
+
+	for (i = 0, n1 = 0; i < n; ++i)
+		if (is_lms (&o, SA[i]))
+			SA[n1++] = SA[i];
+
+	for (i = n1; i < n; ++i)
+		SA[i] = -1;
+
+	for (i = 0, name = 0, prev = -1; i < n1; ++i) {
+		pos = SA[i];
+
+		if (prev < 0 || !lms_equal (&o, pos, prev)) {
+			++name;
+			prev = pos;
+		}
+
+		SA[n1 + pos / 2] = name - 1;
+	}
+
+	for (i = n - 1, j = n - 1; i >= n1; --i)
+		if (SA[i] >= 0)
+			SA[j--] = SA[i];
+
+	/* stage 2: sort the reduced string, recurse if names are not unique */
+
+	s1 = SA + n - n1;
+
+	if (name < n1)
+		sais_run (s1, 1, n1, name, SA, bkt + k, t + n / 8 + 1);
+	else
+		for (i = 0; i < n1; ++i)
+			SA[s1[i]] = i;
+
+	/* stage 3: induce the result from the sorted LMS suffixes */
+
+	for (i = 1, j = 0; i < n; ++i)
+		if (is_lms (&o, i))
+			s1[j++] = i;
+
+	for (i = 0; i < n1; ++i)
+		SA[i] = s1[SA[i]];
+
+	for (i = n1; i < n; ++i)
+		SA[i] = -1;
+
+	get_buckets (&o, 1);
+
+	for (i = n1 - 1; i >= 0; --i) {
+		j = SA[i];
+		SA[i] = -1;
+		SA[--o.bkt[chr (&o, j)]] = j;
+	}
+
+	induce (&o, SA);
+}
+
+/*
+ * Buckets of all levels take at most 256 + (n + 1) items, type bits of
+ * a level of length m take m / 8 + 1 bytes, lengths halve with every
+ * level, and there are 32 levels at most.
+ */
+size_t sais_work_size (size_t n)
+{
+	return (256 + n + 1) * sizeof (int32_t) + (n + 1) / 4 + 32;
+}
+
+int sais (const char *s, size_t n, int32_t *SA, void *work)
+{
+	int32_t *bkt = work;
+
+	if (n >= INT32_MAX) {
+		errno = EOVERFLOW;
+		return 0;
+	}
+
+	if (n == 0) {
+		SA[0] = 0;
+		return 1;
+	}
+
+	if (work == NULL && (bkt = malloc (sais_work_size (n))) == NULL)
+		return 0;
+
+	sais_run (s, 0, n + 1, 256, SA, bkt,
+		  (unsigned char *) (bkt + 256 + n + 1));
+
+	if (work == NULL)
+		free (bkt);
+
+	return 1;
+}
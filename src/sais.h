@@ -0,0 +1,30 @@
+/*
+ * Linear Time Suffix Array Construction
+ *
+ * Copyright (c) 2025 Alexei A. Smekalkine <ikle@ikle.ru>
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#ifndef SAIS_H
+#define SAIS_H  1
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * sais builds the suffix array of the NUL-terminated string s of length n
+ * using the SA-IS algorithm (Nong, Zhang and Chan, 2009). The array SA of
+ * n + 1 entries receives offsets of all suffixes including the empty one
+ * in the strcmp order, thus SA[0] = n and SA + 1 is the sorted array of
+ * non-empty suffixes. Returns zero and sets errno on error (EOVERFLOW if
+ * the string is longer than INT32_MAX - 1 characters).
+ *
+ * The scratch space work of sais_work_size (n) bytes aligned for int32_t
+ * holds buckets and suffix types of all recursion levels, if it is NULL
+ * then sais allocates it for the call.
+ */
+size_t sais_work_size (size_t n);
+int sais (const char *s, size_t n, int32_t *SA, void *work);
+
+#endif  /* SAIS_H */
@@ -0,0 +1,114 @@
+/*
+ * Output Span List
+ *
+ * Copyright (c) 2025 Alexei A. Smekalkine <ikle@ikle.ru>
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <errno.h>
+#include <limits.h>
+
+#include <unistd.h>
+
+#include "spans.h"
+
+#ifndef IOV_MAX
+#define IOV_MAX	1024
+#endif
+
+static int spans_resize (struct spans *o)
+{
+	struct iovec *p;
+	const size_t next = o->size == 0 ? 16 : o->size * 2;
+
+	if (next < o->size || next > (size_t) -1 / sizeof (p[0])) {
+		errno = ENOMEM;  /* size overflow */
+		return 0;
+	}
+
+	if ((p = realloc (o->span, next * sizeof (p[0]))) == NULL)
+		return 0;
+
+	o->span = p;
+	o->size = next;
+	return 1;
+}
+
+int spans_add (struct spans *o, const void *data, size_t len)
+{
+	struct iovec *last;
+
+	if (len == 0)
+		return 1;
+
+	if (o->count > 0) {
+		last = o->span + o->count - 1;
+
+		if ((const char *) last->iov_base + last->iov_len == data) {
+			last->iov_len += len;
+			o->total      += len;
+			return 1;
+		}
+	}
+
+	if (o->count >= o->size && !spans_resize (o))
+		return 0;
+
+	o->span[o->count].iov_base = (void *) data;
+	o->span[o->count].iov_len  = len;
+	++o->count;
+	o->total += len;
+	return 1;
+}
+
+int spans_gather (const struct spans *o, struct blob *out)
+{
+	size_t i;
+
+	if (!blob_reserve (out, o->total))
+		return 0;
+
+	for (i = 0; i < o->count; ++i)
+		if (!blob_write (out, o->span[i].iov_base, o->span[i].iov_len))
+			return 0;
+
+	return 1;
+}
+
+int spans_write (struct spans *o, int fd)
+{
+	struct iovec *v = o->span;
+	size_t n = o->count;
+	ssize_t len;
+
+	while (n > 0) {
+		if (v->iov_len == 0) {	/* thus data remains in every batch */
+			++v, --n;
+			continue;
+		}
+
+		if ((len = writev (fd, v, n < IOV_MAX ? n : IOV_MAX)) < 0) {
+			if (errno == EINTR)
+				continue;
+
+			return 0;
+		}
+
+		if (len == 0) {		/* no progress, do not spin */
+			errno = EIO;
+			return 0;
+		}
+
+		for (; n > 0 && (size_t) len >= v->iov_len; ++v, --n)
+			len -= v->iov_len;
+
+		if (n > 0) {		/* partial write, skip written part */
+			v->iov_base = (char *) v->iov_base + len;
+			v->iov_len -= len;
+		}
+	}
+
+	spans_reset (o);
+	return 1;
+}
@@ -0,0 +1,67 @@
+/*
+ * Output Span List
+ *
+ * Copyright (c) 2025 Alexei A. Smekalkine <ikle@ikle.ru>
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#ifndef SPANS_H
+#define SPANS_H  1
+
+#include <stdlib.h>
+
+#include <sys/uio.h>
+
+#include "blob.h"
+
+struct spans {
+	size_t count, size;	/* number of spans and available space	*/
+	struct iovec *span;	/* spans, pointers to data of others	*/
+	size_t total;		/* total length of all spans		*/
+};
+
+static inline void spans_init (struct spans *o)
+{
+	o->count = 0;
+	o->size  = 0;
+	o->span  = NULL;
+	o->total = 0;
+}
+
+static inline void spans_fini (struct spans *o)
+{
+	free (o->span);
+}
+
+static inline void spans_reset (struct spans *o)
+{
+	o->count = 0;
+	o->total = 0;
+}
+
+/*
+ * spans_add appends a reference to the block of data to the span list,
+ * the data is not copied and must live until the list is consumed. The
+ * block that directly follows the last span extends it.
+ */
+int spans_add (struct spans *o, const void *data, size_t len);
+
+/* returns non-zero if the span list refers exactly to the block of data */
+static inline int spans_is (const struct spans *o, const void *data, size_t len)
+{
+	return o->total == len &&
+	       (o->count == 0 || (o->count == 1 && o->span[0].iov_base == data));
+}
+
+/*
+ * spans_gather appends data of all spans to the blob, one copy per span.
+ *
+ * spans_write writes data of all spans to the file descriptor with as
+ * few writev calls as possible and resets the span list. A write that
+ * makes no progress fails with errno set to EIO.
+ */
+int spans_gather (const struct spans *o, struct blob *out);
+int spans_write  (struct spans *o, int fd);
+
+#endif  /* SPANS_H */